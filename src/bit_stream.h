@@ -0,0 +1,132 @@
+#pragma once
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <vector>
+
+// packs values with an arbitrary number of bits into a byte buffer (least significant bit first)
+class BitWriter
+{
+public:
+    void WriteBits(std::uint64_t value, unsigned count)
+    {
+        for (unsigned i = 0; i < count; ++i)
+        {
+            if (bit_count_ % 8 == 0)
+            {
+                buffer_.push_back(0);
+            }
+            if ((value >> i) & 1)
+            {
+                buffer_.back() |= static_cast<std::uint8_t>(1 << (bit_count_ % 8));
+            }
+            ++bit_count_;
+        }
+    }
+
+    void WriteBool(bool value)
+    {
+        WriteBits(value ? 1 : 0, 1);
+    }
+
+    // variable length encoding: groups of 7 bits, each followed by a bit indicating whether more groups follow
+    // small values (like the difference between two sorted entity IDs) only need a few bits this way
+    void WriteVarUint(std::uint64_t value)
+    {
+        do
+        {
+            WriteBits(value & 0x7f, 7);
+            value >>= 7;
+            WriteBool(value != 0);
+        } while (value != 0);
+    }
+
+    std::uint64_t GetBitCount() const
+    {
+        return bit_count_;
+    }
+
+    const std::vector<std::uint8_t>& GetBuffer() const
+    {
+        return buffer_;
+    }
+
+private:
+    std::vector<std::uint8_t> buffer_;
+    std::uint64_t bit_count_ = 0;
+};
+
+// counterpart of BitWriter
+// reading past the end of the buffer yields zeros and sets a flag which can be checked with Ok()
+class BitReader
+{
+public:
+    explicit BitReader(const std::vector<std::uint8_t>& buffer) : buffer_(buffer)
+    {
+    }
+
+    std::uint64_t ReadBits(unsigned count)
+    {
+        std::uint64_t value = 0;
+        for (unsigned i = 0; i < count; ++i)
+        {
+            if (bit_position_ >= 8 * buffer_.size())
+            {
+                overflow_ = true;
+                return 0;
+            }
+            if ((buffer_[bit_position_ / 8] >> (bit_position_ % 8)) & 1)
+            {
+                value |= std::uint64_t(1) << i;
+            }
+            ++bit_position_;
+        }
+        return value;
+    }
+
+    bool ReadBool()
+    {
+        return ReadBits(1) != 0;
+    }
+
+    std::uint64_t ReadVarUint()
+    {
+        std::uint64_t value = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7)
+        {
+            value |= ReadBits(7) << shift;
+            if (!ReadBool())
+            {
+                return value;
+            }
+        }
+        // too many groups, the data is corrupt
+        overflow_ = true;
+        return 0;
+    }
+
+    bool Ok() const
+    {
+        return !overflow_;
+    }
+
+private:
+    const std::vector<std::uint8_t>& buffer_;
+    std::uint64_t bit_position_ = 0;
+    bool overflow_ = false;
+};
+
+// map a float in [min, max] to an integer with the given number of bits (values outside are clamped)
+inline std::uint64_t QuantizeFloat(float value, float min, float max, unsigned bits)
+{
+    const std::uint64_t steps = (std::uint64_t(1) << bits) - 1;
+    const float normalized = (std::min(std::max(value, min), max) - min) / (max - min);
+    return static_cast<std::uint64_t>(std::lround(normalized * steps));
+}
+
+inline float DequantizeFloat(std::uint64_t value, float min, float max, unsigned bits)
+{
+    const std::uint64_t steps = (std::uint64_t(1) << bits) - 1;
+    return min + (max - min) * static_cast<float>(value) / steps;
+}
@@ -0,0 +1,255 @@
+#include <algorithm>
+
+#include "block_update_process.h"
+
+namespace {
+    const int DIRECTIONS[6][3] = {{-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}};
+
+    BlockCoord BlockOf(int index, ChunkCoord coord)
+    {
+        // see Chunk::IndexOf
+        return BlockCoord{coord.x * CHUNK_SIZE + index % CHUNK_SIZE, coord.y * CHUNK_SIZE + index / (CHUNK_SIZE * CHUNK_SIZE), coord.z * CHUNK_SIZE + (index / CHUNK_SIZE) % CHUNK_SIZE};
+    }
+
+    // active blocks of one chunk and the output of their rules
+    struct ChunkWork
+    {
+        ChunkCoord coord;
+        const std::map<BlockType, BlockRule>* rules;
+        std::vector<int> blocks;
+        BlockUpdateOutput output;
+        // per called rule: its block and the end of its changes in output.changes
+        std::vector<std::pair<BlockCoord, std::size_t>> rule_changes;
+    };
+}
+
+BlockUpdateProcess::BlockUpdateProcess(VoxelWorld& world, unsigned thread_count, int random_ticks_per_chunk)
+    : world_(world), thread_pool_(thread_count), random_ticks_per_chunk_(random_ticks_per_chunk), random_(0)
+{
+    world_observer_ = world_.Observe([this](int x, int y, int z, bool whole_chunk) { OnBlockChanged(x, y, z, whole_chunk); });
+}
+
+BlockUpdateProcess::~BlockUpdateProcess()
+{
+    world_.Unobserve(world_observer_);
+}
+
+void BlockUpdateProcess::RegisterRule(BlockType type, BlockRule rule)
+{
+    rules_[type] = rule;
+}
+
+void BlockUpdateProcess::RegisterRandomTickRule(BlockType type, BlockRule rule)
+{
+    random_tick_rules_[type] = rule;
+}
+
+void BlockUpdateProcess::Schedule(const BlockCoord& block, TickType delay)
+{
+    const TickType tick = tick_ + std::max<TickType>(delay, 1);
+    const ChunkCoord coord = ChunkCoordOf(block);
+    const int index = Chunk::IndexOf(block.x - coord.x * CHUNK_SIZE, block.y - coord.y * CHUNK_SIZE, block.z - coord.z * CHUNK_SIZE);
+    ChunkSchedule& schedule = schedules_[coord];
+    auto it = schedule.due.find(index);
+    if (it != schedule.due.end())
+    {
+        if (it->second <= tick)
+        {
+            return;
+        }
+        schedule.queue.erase({it->second, index});
+    }
+    schedule.due[index] = tick;
+    schedule.queue.insert({tick, index});
+}
+
+void BlockUpdateProcess::Update()
+{
+    ++tick_;
+
+    /* collect the due blocks per chunk */
+
+    std::vector<ChunkWork> work;
+    for (auto it = schedules_.begin(); it != schedules_.end();)
+    {
+        ChunkSchedule& schedule = it->second;
+        ChunkWork chunk_work{it->first, &rules_, {}, {}, {}};
+        while (!schedule.queue.empty() && schedule.queue.begin()->first <= tick_)
+        {
+            const int index = schedule.queue.begin()->second;
+            chunk_work.blocks.push_back(index);
+            schedule.due.erase(index);
+            schedule.queue.erase(schedule.queue.begin());
+        }
+        if (!chunk_work.blocks.empty())
+        {
+            work.push_back(std::move(chunk_work));
+        }
+        it = schedule.queue.empty() ? schedules_.erase(it) : std::next(it);
+    }
+    if (random_ticks_per_chunk_ > 0 && !random_tick_rules_.empty())
+    {
+        // random tick rules rejected in the last tick are called again (before the new random blocks)
+        std::map<ChunkCoord, std::vector<int>> retries;
+        for (auto const& block : random_tick_retries_)
+        {
+            const ChunkCoord coord = ChunkCoordOf(block);
+            retries[coord].push_back(Chunk::IndexOf(block.x - coord.x * CHUNK_SIZE, block.y - coord.y * CHUNK_SIZE, block.z - coord.z * CHUNK_SIZE));
+        }
+        random_tick_retries_.clear();
+
+        std::uniform_int_distribution<int> distribution(0, CHUNK_VOLUME - 1);
+        for (auto const& i : world_.GetChunks())
+        {
+            ChunkWork chunk_work{i.first, &random_tick_rules_, {}, {}, {}};
+            auto retry = retries.find(i.first);
+            if (retry != retries.end())
+            {
+                chunk_work.blocks = std::move(retry->second);
+            }
+            for (int n = 0; n < random_ticks_per_chunk_; ++n)
+            {
+                const int index = distribution(random_);
+                if (random_tick_rules_.count(i.second->GetBlocks()[index]) > 0)
+                {
+                    chunk_work.blocks.push_back(index);
+                }
+            }
+            if (!chunk_work.blocks.empty())
+            {
+                work.push_back(std::move(chunk_work));
+            }
+        }
+    }
+
+    /* call the rules in parallel, they only read the world */
+
+    const VoxelWorld& world = world_;
+    thread_pool_.ParallelFor(work.size(), [&work, &world](std::size_t i) {
+        ChunkWork& chunk_work = work[i];
+        auto chunk = world.GetChunk(chunk_work.coord);
+        if (!chunk)
+        {
+            return;
+        }
+        for (auto index : chunk_work.blocks)
+        {
+            auto rule = chunk_work.rules->find(chunk->GetBlocks()[index]);
+            if (rule != chunk_work.rules->end())
+            {
+                const BlockCoord block = BlockOf(index, chunk_work.coord);
+                rule->second(world, block, chunk_work.output);
+                chunk_work.rule_changes.push_back({block, chunk_work.output.changes.size()});
+            }
+        }
+    });
+
+    /*
+    apply the changes (which schedules the neighbors via OnBlockChanged)
+    The changes of a rule are applied all or nothing: if one of its blocks has already been written by another rule in
+    this tick (e.g. sand and water moving into the same block), none are applied and the rule is called again in the
+    next tick, when it sees the result of the other rule. Otherwise, one of the moving blocks would be lost.
+    */
+
+    active_count_ = 0;
+    conflict_count_ = 0;
+    std::set<BlockCoord> written;
+    for (auto& chunk_work : work)
+    {
+        active_count_ += chunk_work.blocks.size();
+        std::size_t begin = 0;
+        for (auto const& rule_changes : chunk_work.rule_changes)
+        {
+            const auto first = chunk_work.output.changes.begin() + begin;
+            const auto last = chunk_work.output.changes.begin() + rule_changes.second;
+            begin = rule_changes.second;
+            if (std::any_of(first, last, [&written](const std::pair<BlockCoord, BlockType>& change) { return written.count(change.first) > 0; }))
+            {
+                ++conflict_count_;
+                // random tick rules are not found via the schedule
+                if (chunk_work.rules == &random_tick_rules_)
+                {
+                    random_tick_retries_.push_back(rule_changes.first);
+                }
+                else
+                {
+                    Schedule(rule_changes.first, 1);
+                }
+                continue;
+            }
+            for (auto it = first; it != last; ++it)
+            {
+                written.insert(it->first);
+                if (world_.GetBlock(it->first.x, it->first.y, it->first.z) != it->second)
+                {
+                    world_.SetBlock(it->first.x, it->first.y, it->first.z, it->second);
+                }
+            }
+        }
+        for (auto const& schedule : chunk_work.output.schedules)
+        {
+            Schedule(schedule.first, schedule.second);
+        }
+    }
+}
+
+TickType BlockUpdateProcess::GetTick() const
+{
+    return tick_;
+}
+
+std::uint64_t BlockUpdateProcess::GetActiveCount() const
+{
+    return active_count_;
+}
+
+std::uint64_t BlockUpdateProcess::GetConflictCount() const
+{
+    return conflict_count_;
+}
+
+std::uint64_t BlockUpdateProcess::GetScheduledCount() const
+{
+    std::uint64_t count = 0;
+    for (auto const& i : schedules_)
+    {
+        count += i.second.due.size();
+    }
+    return count;
+}
+
+void BlockUpdateProcess::ScheduleIfRule(const BlockCoord& block, TickType delay)
+{
+    if (rules_.find(world_.GetBlock(block.x, block.y, block.z)) != rules_.end())
+    {
+        Schedule(block, delay);
+    }
+}
+
+void BlockUpdateProcess::OnBlockChanged(int x, int y, int z, bool whole_chunk)
+{
+    if (whole_chunk)
+    {
+        // a chunk was loaded (or replaced): activate its blocks which have rules
+        const ChunkCoord coord = ChunkCoordOf(x, y, z);
+        auto chunk = world_.GetChunk(coord);
+        if (!chunk)
+        {
+            schedules_.erase(coord);
+            return;
+        }
+        for (int index = 0; index < CHUNK_VOLUME; ++index)
+        {
+            if (rules_.find(chunk->GetBlocks()[index]) != rules_.end())
+            {
+                Schedule(BlockOf(index, coord), 1);
+            }
+        }
+        return;
+    }
+    ScheduleIfRule(BlockCoord{x, y, z}, 1);
+    for (auto const& d : DIRECTIONS)
+    {
+        ScheduleIfRule(BlockCoord{x + d[0], y + d[1], z + d[2]}, 1);
+    }
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cinttypes>
+#include <functional>
+#include <map>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "chunk.h"
+#include "process.h"
+#include "thread_pool.h"
+#include "type.h"
+#include "voxel_world.h"
+
+// what a block rule wants to happen (applied after all rules of the tick ran)
+struct BlockUpdateOutput
+{
+    void SetBlock(const BlockCoord& block, BlockType type)
+    {
+        changes.push_back({block, type});
+    }
+
+    void Schedule(const BlockCoord& block, TickType delay)
+    {
+        schedules.push_back({block, delay});
+    }
+
+    std::vector<std::pair<BlockCoord, BlockType>> changes;
+    std::vector<std::pair<BlockCoord, TickType>> schedules;
+};
+
+// called for an active block, may only read the world (it runs in parallel with other rules)
+using BlockRule = std::function<void(const VoxelWorld& world, const BlockCoord& block, BlockUpdateOutput& output)>;
+
+/*
+Simulation of blocks (flowing water, falling sand, growing crops, ...) which only touches blocks that can change.
+
+Every chunk has a queue of blocks scheduled for a tick. A block is scheduled when it or one of its neighbors changed
+(if there is a rule for its type), or when a rule asks for it. Random tick rules are called for a few randomly chosen
+blocks per loaded chunk and tick instead.
+
+Every update (one tick) has two phases. First, the rules of all due blocks are called in parallel on the worker threads;
+they only read the world and write their changes to per-chunk buffers. Second, the changes are applied to the world in
+chunk order, which schedules the changed blocks and their neighbors for the next tick. The changes of a rule which touch a
+block already written in this tick are rejected as a whole, and the rule (scheduled or random tick) is called again in the
+next tick. The cost of a tick is thus proportional to the number of active blocks, not to the size of the world.
+*/
+class BlockUpdateProcess : public IProcess
+{
+public:
+    BlockUpdateProcess(VoxelWorld& world, unsigned thread_count, int random_ticks_per_chunk = 0);
+    ~BlockUpdateProcess();
+
+    // called for scheduled blocks of the type
+    void RegisterRule(BlockType type, BlockRule rule);
+    // called for randomly chosen blocks of the type (crops, grass, ...)
+    void RegisterRandomTickRule(BlockType type, BlockRule rule);
+    // the block is updated in delay ticks (at least 1)
+    void Schedule(const BlockCoord& block, TickType delay);
+    void Update();
+
+    TickType GetTick() const;
+    // number of blocks whose rules were called in the last update
+    std::uint64_t GetActiveCount() const;
+    // number of rules rejected in the last update because they wrote blocks already written by other rules
+    std::uint64_t GetConflictCount() const;
+    // number of scheduled blocks
+    std::uint64_t GetScheduledCount() const;
+
+private:
+    struct ChunkSchedule
+    {
+        // earliest tick per scheduled block (local index, see Chunk::IndexOf)
+        std::map<int, TickType> due;
+        // the same, ordered by tick
+        std::set<std::pair<TickType, int>> queue;
+    };
+
+    void ScheduleIfRule(const BlockCoord& block, TickType delay);
+    void OnBlockChanged(int x, int y, int z, bool whole_chunk);
+
+    VoxelWorld& world_;
+    ObserverIdType world_observer_;
+    ThreadPool thread_pool_;
+    int random_ticks_per_chunk_;
+    std::mt19937 random_;
+    TickType tick_ = 0;
+    std::uint64_t active_count_ = 0;
+    std::uint64_t conflict_count_ = 0;
+    std::map<BlockType, BlockRule> rules_;
+    std::map<BlockType, BlockRule> random_tick_rules_;
+    std::map<ChunkCoord, ChunkSchedule> schedules_;
+    // blocks whose random tick rules were rejected in the last tick
+    std::vector<BlockCoord> random_tick_retries_;
+};
@@ -15,5 +15,5 @@ template <typename T>
 class CallbackMap : public ICallbackMap
 {
 public:
-    std::map<ProcessIdType, std::function<void(T)>> map_;
+    std::map<ProcessIdType, std::function<void(T&)>> map_;
 };
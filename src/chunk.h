@@ -0,0 +1,116 @@
+#pragma once
+
+#include <array>
+#include <cinttypes>
+
+using BlockType = std::uint8_t;
+
+const BlockType AIR = 0;
+const int CHUNK_SIZE = 16;
+const int CHUNK_VOLUME = CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE;
+
+// position of a chunk in chunk units (the chunk covers the blocks CHUNK_SIZE * x to CHUNK_SIZE * x + CHUNK_SIZE - 1 etc.)
+struct ChunkCoord
+{
+    bool operator <(const ChunkCoord& rhs) const
+    {
+        if (x != rhs.x)
+        {
+            return x < rhs.x;
+        }
+        if (y != rhs.y)
+        {
+            return y < rhs.y;
+        }
+        return z < rhs.z;
+    }
+
+    bool operator ==(const ChunkCoord& rhs) const
+    {
+        return x == rhs.x && y == rhs.y && z == rhs.z;
+    }
+
+    int x = 0;
+    int y = 0;
+    int z = 0;
+};
+
+// position of a block in world coordinates
+struct BlockCoord
+{
+    bool operator <(const BlockCoord& rhs) const
+    {
+        if (x != rhs.x)
+        {
+            return x < rhs.x;
+        }
+        if (y != rhs.y)
+        {
+            return y < rhs.y;
+        }
+        return z < rhs.z;
+    }
+
+    bool operator ==(const BlockCoord& rhs) const
+    {
+        return x == rhs.x && y == rhs.y && z == rhs.z;
+    }
+
+    int x = 0;
+    int y = 0;
+    int z = 0;
+};
+
+// division rounding towards negative infinity, e.g., to get the chunk of a block with negative coordinates
+inline int FloorDiv(int a, int b)
+{
+    return a / b - ((a % b != 0) && ((a < 0) != (b < 0)));
+}
+
+inline int FloorMod(int a, int b)
+{
+    return a - b * FloorDiv(a, b);
+}
+
+inline ChunkCoord ChunkCoordOf(int x, int y, int z)
+{
+    return ChunkCoord{FloorDiv(x, CHUNK_SIZE), FloorDiv(y, CHUNK_SIZE), FloorDiv(z, CHUNK_SIZE)};
+}
+
+inline ChunkCoord ChunkCoordOf(const BlockCoord& block)
+{
+    return ChunkCoordOf(block.x, block.y, block.z);
+}
+
+// cubic block of CHUNK_SIZE^3 blocks, accessed with local coordinates in [0, CHUNK_SIZE)
+class Chunk
+{
+public:
+    Chunk()
+    {
+        blocks_.fill(AIR);
+    }
+
+    static int IndexOf(int x, int y, int z)
+    {
+        return (y * CHUNK_SIZE + z) * CHUNK_SIZE + x;
+    }
+
+    BlockType GetBlock(int x, int y, int z) const
+    {
+        return blocks_[IndexOf(x, y, z)];
+    }
+
+    void SetBlock(int x, int y, int z, BlockType block)
+    {
+        blocks_[IndexOf(x, y, z)] = block;
+    }
+
+    const std::array<BlockType, CHUNK_VOLUME>& GetBlocks() const
+    {
+        return blocks_;
+    }
+
+private:
+    std::array<BlockType, CHUNK_VOLUME> blocks_;
+};
@@ -0,0 +1,77 @@
+#include <vector>
+
+#include "chunk_connectivity.h"
+
+ChunkConnectivity ChunkConnectivity::Compute(const Chunk& chunk)
+{
+    ChunkConnectivity connectivity;
+    const auto& blocks = chunk.GetBlocks();
+    std::vector<char> visited(CHUNK_VOLUME, 0);
+    std::vector<int> stack;
+
+    for (int start = 0; start < CHUNK_VOLUME; ++start)
+    {
+        if (visited[start] || blocks[start] != AIR)
+        {
+            continue;
+        }
+
+        // flood fill one connected region of air and collect the faces it touches
+        int faces = 0;
+        visited[start] = 1;
+        stack.push_back(start);
+        while (!stack.empty())
+        {
+            const int index = stack.back();
+            stack.pop_back();
+            // see Chunk::IndexOf
+            const int x = index % CHUNK_SIZE;
+            const int z = (index / CHUNK_SIZE) % CHUNK_SIZE;
+            const int y = index / (CHUNK_SIZE * CHUNK_SIZE);
+            const int coords[3] = {x, y, z};
+            const int strides[3] = {1, CHUNK_SIZE * CHUNK_SIZE, CHUNK_SIZE};
+
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                // ChunkFace order is -x, +x, -y, +y, -z, +z
+                if (coords[axis] == 0)
+                {
+                    faces |= 1 << (2 * axis);
+                }
+                else if (!visited[index - strides[axis]] && blocks[index - strides[axis]] == AIR)
+                {
+                    visited[index - strides[axis]] = 1;
+                    stack.push_back(index - strides[axis]);
+                }
+                if (coords[axis] == CHUNK_SIZE - 1)
+                {
+                    faces |= 1 << (2 * axis + 1);
+                }
+                else if (!visited[index + strides[axis]] && blocks[index + strides[axis]] == AIR)
+                {
+                    visited[index + strides[axis]] = 1;
+                    stack.push_back(index + strides[axis]);
+                }
+            }
+        }
+
+        for (int face0 = 0; face0 < 6; ++face0)
+        {
+            for (int face1 = 0; face1 < 6; ++face1)
+            {
+                if ((faces >> face0 & 1) && (faces >> face1 & 1))
+                {
+                    connectivity.Connect(face0, face1);
+                }
+            }
+        }
+    }
+    return connectivity;
+}
+
+ChunkConnectivity ChunkConnectivity::AllConnected()
+{
+    ChunkConnectivity connectivity;
+    connectivity.bits_ = (std::uint64_t(1) << 36) - 1;
+    return connectivity;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cinttypes>
+
+#include "chunk.h"
+
+// faces of a chunk, the opposite face of f is f ^ 1
+enum ChunkFace
+{
+    kNegX = 0,
+    kPosX = 1,
+    kNegY = 2,
+    kPosY = 3,
+    kNegZ = 4,
+    kPosZ = 5
+};
+
+/*
+Which faces of a chunk are connected through non-solid (air) blocks, i.e., whether one could look into the chunk
+through one face and out of it through another one. Computed with a flood fill over the air blocks of the chunk.
+*/
+class ChunkConnectivity
+{
+public:
+    static ChunkConnectivity Compute(const Chunk& chunk);
+    // e.g. for chunks which are not loaded
+    static ChunkConnectivity AllConnected();
+
+    bool IsConnected(int face0, int face1) const
+    {
+        return (bits_ >> (face0 * 6 + face1)) & 1;
+    }
+
+    void Connect(int face0, int face1)
+    {
+        bits_ |= std::uint64_t(1) << (face0 * 6 + face1);
+        bits_ |= std::uint64_t(1) << (face1 * 6 + face0);
+    }
+
+private:
+    // 6 x 6 bit matrix
+    std::uint64_t bits_ = 0;
+};
@@ -1,19 +1,571 @@
 #pragma once
 
+#include <algorithm>
+#include <cinttypes>
+#include <istream>
 #include <map>
+#include <memory>
+#include <ostream>
+#include <type_traits>
+#include <vector>
 
+#include "bit_stream.h"
 #include "entity.h"
+#include "network_codec.h"
+#include "pool_allocator.h"
+#include "serializer.h"
 #include "type.h"
 
 class IComponentMap
 {
 public:
     virtual ~IComponentMap() = default;
+
+    // remove the component of the given entity (if there is one), the removal is recorded with the given tick
+    virtual void Erase(Entity, TickType) = 0;
+    // deep copy, used to fork the state of an entity manager
+    virtual std::shared_ptr<IComponentMap> Clone() const = 0;
+    // empty map for the same component type
+    virtual std::shared_ptr<IComponentMap> CreateEmpty() const = 0;
+    // exchange the contents with a map of the same component type
+    virtual void Swap(IComponentMap&) = 0;
+    // write/read all components as one block (see serializer.h)
+    virtual bool Write(std::ostream&) const = 0;
+    virtual bool Read(std::istream&) = 0;
+    // IDs of the entities which have a component, sorted
+    virtual std::vector<EntityIdType> GetEntityIds() const = 0;
+
+    /* change tracking and delta encoding (see README) */
+
+    // mark all components as changed at the given tick
+    virtual void MarkAllChanged(TickType) = 0;
+    // forget removals which happened at or before the given tick
+    virtual void DiscardRemovalsUpTo(TickType) = 0;
+    // write all components changed and removed after the given tick
+    virtual void EncodeDelta(BitWriter&, TickType since) const = 0;
+    // read what EncodeDelta wrote: the changed components are stored in this map, the entities are returned
+    virtual bool DecodeDelta(BitReader&, std::vector<Entity>& changed, std::vector<Entity>& removed) = 0;
+    // apply a delta decoded into another map (of the same component type)
+    virtual void MergeDelta(IComponentMap& decoded, const std::vector<Entity>& removed, TickType) = 0;
+
+    /* compaction (see EntityManager::CompactComponents) */
+
+    // nodes allocated from freed ones plus unused nodes, relative to the size (counted by the pools, so it costs nothing)
+    virtual double GetDisorder() const = 0;
+    // move up to max_nodes components (in entity ID order) to new nodes which lie next to each other in memory,
+    // returns true when all components have been moved, the next call continues where the last one stopped
+    virtual bool Compact(std::size_t max_nodes) = 0;
 };
 
 template <typename T>
 class ComponentMap : public IComponentMap
 {
 public:
-    std::map<Entity, T> entity_component_map_;
+    void Erase(Entity entity, TickType tick) override
+    {
+        if (entity_component_map_.erase(entity) > 0)
+        {
+            change_tick_.erase(entity);
+            removal_tick_[entity] = tick;
+        }
+    }
+
+    void MarkChanged(Entity entity, TickType tick)
+    {
+        change_tick_[entity] = tick;
+        removal_tick_.erase(entity);
+    }
+
+    std::shared_ptr<IComponentMap> Clone() const override
+    {
+        return std::make_shared<ComponentMap<T>>(*this);
+    }
+
+    std::shared_ptr<IComponentMap> CreateEmpty() const override
+    {
+        return std::make_shared<ComponentMap<T>>();
+    }
+
+    void Swap(IComponentMap& other) override
+    {
+        auto& other_map = static_cast<ComponentMap<T>&>(other);
+        entity_component_map_.swap(other_map.entity_component_map_);
+        std::swap(compaction_next_, other_map.compaction_next_);
+        change_tick_.swap(other_map.change_tick_);
+        removal_tick_.swap(other_map.removal_tick_);
+    }
+
+    /*
+    Block layout:
+    schema version | size of T | number of components | entity IDs | components
+    The entity IDs are sorted (since std::map is), the components are stored in the same order.
+    */
+    bool Write(std::ostream& os) const override
+    {
+        if constexpr (!IsSerializable<T>())
+        {
+            return false;
+        }
+        else
+        {
+            const std::uint64_t count = entity_component_map_.size();
+            WriteValue(os, Serializer<T>::kVersion);
+            WriteValue(os, static_cast<std::uint64_t>(sizeof(T)));
+            WriteValue(os, count);
+
+            std::vector<EntityIdType> ids;
+            ids.reserve(count);
+            for (auto const& i : entity_component_map_)
+            {
+                ids.push_back(i.first.id_);
+            }
+            WriteBlock(os, ids.data(), count);
+
+            if constexpr (Serializer<T>::kCustom)
+            {
+                for (auto const& i : entity_component_map_)
+                {
+                    Serializer<T>::Write(os, i.second);
+                }
+            }
+            else
+            {
+                // gather the components so that they can be written with a single call
+                std::vector<T> components;
+                components.reserve(count);
+                for (auto const& i : entity_component_map_)
+                {
+                    components.push_back(i.second);
+                }
+                WriteBlock(os, components.data(), count);
+            }
+            return static_cast<bool>(os);
+        }
+    }
+
+    bool Read(std::istream& is) override
+    {
+        if constexpr (!IsSerializable<T>())
+        {
+            return false;
+        }
+        else
+        {
+            std::uint32_t version;
+            std::uint64_t size;
+            std::uint64_t count;
+            if (!ReadValue(is, version) || !ReadValue(is, size) || !ReadCount(is, count, sizeof(EntityIdType) + (Serializer<T>::kCustom ? 0 : sizeof(T))))
+            {
+                return false;
+            }
+            // the schema of the snapshot has to match the schema of the component type
+            if (version != Serializer<T>::kVersion || (!Serializer<T>::kCustom && size != sizeof(T)))
+            {
+                return false;
+            }
+
+            std::vector<EntityIdType> ids(count);
+            if (!ReadBlock(is, ids.data(), count))
+            {
+                return false;
+            }
+
+            std::vector<T> components(count);
+            if constexpr (Serializer<T>::kCustom)
+            {
+                for (auto& component : components)
+                {
+                    if (!Serializer<T>::Read(is, component))
+                    {
+                        return false;
+                    }
+                }
+            }
+            else
+            {
+                if (!ReadBlock(is, components.data(), count))
+                {
+                    return false;
+                }
+            }
+
+            // the IDs are sorted, so inserting at the end is amortized constant time (no search per entity)
+            entity_component_map_.clear();
+            for (std::uint64_t i = 0; i < count; ++i)
+            {
+                entity_component_map_.emplace_hint(entity_component_map_.end(), Entity{ids[i]}, std::move(components[i]));
+            }
+            return true;
+        }
+    }
+
+    void MarkAllChanged(TickType tick) override
+    {
+        change_tick_.clear();
+        for (auto const& i : entity_component_map_)
+        {
+            change_tick_.emplace_hint(change_tick_.end(), i.first, tick);
+        }
+    }
+
+    void DiscardRemovalsUpTo(TickType tick) override
+    {
+        for (auto it = removal_tick_.begin(); it != removal_tick_.end();)
+        {
+            it = it->second <= tick ? removal_tick_.erase(it) : std::next(it);
+        }
+    }
+
+    /*
+    Delta layout:
+    replicated flag | number of changed components | per changed component: entity ID gap, component
+    | number of removed components | per removed component: entity ID gap
+    The entity IDs are sorted, so only the (usually small) gap to the previous ID is written as a variable length integer.
+    */
+    void EncodeDelta(BitWriter& writer, TickType since) const override
+    {
+        writer.WriteBool(IsReplicable<T>());
+        if constexpr (IsReplicable<T>())
+        {
+            std::vector<Entity> changed;
+            for (auto const& i : change_tick_)
+            {
+                if (i.second > since)
+                {
+                    changed.push_back(i.first);
+                }
+            }
+            writer.WriteVarUint(changed.size());
+            EntityIdType previous_id = 0;
+            for (auto entity : changed)
+            {
+                writer.WriteVarUint(entity.id_ - previous_id);
+                previous_id = entity.id_;
+                EncodeComponent(writer, entity_component_map_.at(entity));
+            }
+
+            std::vector<Entity> removed;
+            for (auto const& i : removal_tick_)
+            {
+                if (i.second > since)
+                {
+                    removed.push_back(i.first);
+                }
+            }
+            writer.WriteVarUint(removed.size());
+            previous_id = 0;
+            for (auto entity : removed)
+            {
+                writer.WriteVarUint(entity.id_ - previous_id);
+                previous_id = entity.id_;
+            }
+        }
+    }
+
+    bool DecodeDelta(BitReader& reader, std::vector<Entity>& changed, std::vector<Entity>& removed) override
+    {
+        const bool replicated = reader.ReadBool();
+        if (!reader.Ok() || replicated != IsReplicable<T>())
+        {
+            return false;
+        }
+        if constexpr (IsReplicable<T>())
+        {
+            const std::uint64_t changed_count = reader.ReadVarUint();
+            EntityIdType id = 0;
+            for (std::uint64_t i = 0; i < changed_count && reader.Ok(); ++i)
+            {
+                id += reader.ReadVarUint();
+                T component;
+                if (!DecodeComponent(reader, component))
+                {
+                    return false;
+                }
+                changed.push_back(Entity{id});
+                entity_component_map_.emplace_hint(entity_component_map_.end(), Entity{id}, std::move(component));
+            }
+
+            const std::uint64_t removed_count = reader.ReadVarUint();
+            id = 0;
+            for (std::uint64_t i = 0; i < removed_count && reader.Ok(); ++i)
+            {
+                id += reader.ReadVarUint();
+                removed.push_back(Entity{id});
+            }
+        }
+        return reader.Ok();
+    }
+
+    void MergeDelta(IComponentMap& decoded, const std::vector<Entity>& removed, TickType tick) override
+    {
+        for (auto& i : static_cast<ComponentMap<T>&>(decoded).entity_component_map_)
+        {
+            entity_component_map_[i.first] = std::move(i.second);
+            MarkChanged(i.first, tick);
+        }
+        for (auto entity : removed)
+        {
+            Erase(entity, tick);
+        }
+    }
+
+    std::vector<EntityIdType> GetEntityIds() const override
+    {
+        std::vector<EntityIdType> ids;
+        ids.reserve(entity_component_map_.size());
+        for (auto const& i : entity_component_map_)
+        {
+            ids.push_back(i.first.id_);
+        }
+        return ids;
+    }
+
+    double GetDisorder() const override
+    {
+        const NodePools& pools = entity_component_map_.get_allocator().GetPools();
+        const std::size_t disorder = pools.GetFreeCount() + pools.GetReusedCount();
+        return static_cast<double>(disorder) / std::max<std::size_t>(entity_component_map_.size(), 1);
+    }
+
+    bool Compact(std::size_t max_nodes) override
+    {
+        auto allocator = entity_component_map_.get_allocator();
+        NodePools& pools = allocator.GetPools();
+        // a map copied or swapped in the meantime has other pools, then start over
+        if (!pools.IsCompacting())
+        {
+            pools.BeginCompaction();
+            compaction_next_ = Entity{0};
+        }
+        // every component is reallocated, new nodes come from new blocks one after the other
+        auto it = entity_component_map_.lower_bound(compaction_next_);
+        for (std::size_t i = 0; i < max_nodes && it != entity_component_map_.end(); ++i)
+        {
+            const Entity entity = it->first;
+            T component = std::move(it->second);
+            it = entity_component_map_.erase(it);
+            entity_component_map_.emplace_hint(it, entity, std::move(component));
+        }
+        if (it == entity_component_map_.end())
+        {
+            // the retired blocks have been released with their last node
+            return true;
+        }
+        compaction_next_ = it->first;
+        return false;
+    }
+
+    using Map = std::map<Entity, T, std::less<Entity>, PoolAllocator<std::pair<const Entity, T>>>;
+
+    // the components, references to them are invalidated by Compact
+    Map entity_component_map_;
+    // first entity whose component has not been moved by the running compaction
+    Entity compaction_next_ = Entity{0};
+    // tick of the last mutable access per component
+    std::map<Entity, TickType> change_tick_;
+    // tick of the removal per removed component (kept until DiscardRemovalsUpTo is called)
+    std::map<Entity, TickType> removal_tick_;
+};
+
+/*
+Map for tag components (empty types, see EntityManager::AddComponent): whether an entity has the tag is only stored in
+its bit field, this map only keeps the ticks needed for delta encoding: the tick of the addition per tagged entity and
+the tick of the removal per removed tag.
+*/
+class TagMap : public IComponentMap
+{
+public:
+    void Erase(Entity entity, TickType tick) override
+    {
+        if (change_tick_.erase(entity) != 0)
+        {
+            removal_tick_[entity] = tick;
+        }
+    }
+
+    void MarkChanged(Entity entity, TickType tick)
+    {
+        change_tick_[entity] = tick;
+        removal_tick_.erase(entity);
+    }
+
+    std::shared_ptr<IComponentMap> Clone() const override
+    {
+        return std::make_shared<TagMap>(*this);
+    }
+
+    std::shared_ptr<IComponentMap> CreateEmpty() const override
+    {
+        return std::make_shared<TagMap>();
+    }
+
+    void Swap(IComponentMap& other) override
+    {
+        auto& other_map = static_cast<TagMap&>(other);
+        change_tick_.swap(other_map.change_tick_);
+        removal_tick_.swap(other_map.removal_tick_);
+    }
+
+    /*
+    Block layout:
+    number of tagged entities | entity IDs
+    */
+    bool Write(std::ostream& os) const override
+    {
+        const std::vector<EntityIdType> ids = ChangedSince(0);
+        WriteValue(os, static_cast<std::uint64_t>(ids.size()));
+        WriteBlock(os, ids.data(), ids.size());
+        return static_cast<bool>(os);
+    }
+
+    bool Read(std::istream& is) override
+    {
+        std::uint64_t count;
+        if (!ReadCount(is, count, sizeof(EntityIdType)))
+        {
+            return false;
+        }
+        std::vector<EntityIdType> ids(count);
+        if (!ReadBlock(is, ids.data(), count))
+        {
+            return false;
+        }
+        change_tick_.clear();
+        for (auto id : ids)
+        {
+            // the IDs are sorted, the actual tick is set by MarkAllChanged
+            change_tick_.emplace_hint(change_tick_.end(), Entity{id}, 1);
+        }
+        return true;
+    }
+
+    void MarkAllChanged(TickType tick) override
+    {
+        for (auto& i : change_tick_)
+        {
+            i.second = tick;
+        }
+    }
+
+    void DiscardRemovalsUpTo(TickType tick) override
+    {
+        for (auto it = removal_tick_.begin(); it != removal_tick_.end();)
+        {
+            it = it->second <= tick ? removal_tick_.erase(it) : std::next(it);
+        }
+    }
+
+    /*
+    Delta layout (like ComponentMap::EncodeDelta without components):
+    replicated flag | number of added tags | entity ID gaps | number of removed tags | entity ID gaps
+    */
+    void EncodeDelta(BitWriter& writer, TickType since) const override
+    {
+        writer.WriteBool(true);
+        const std::vector<EntityIdType> added = ChangedSince(since);
+        writer.WriteVarUint(added.size());
+        EntityIdType previous_id = 0;
+        for (auto id : added)
+        {
+            writer.WriteVarUint(id - previous_id);
+            previous_id = id;
+        }
+
+        std::vector<Entity> removed;
+        for (auto const& i : removal_tick_)
+        {
+            if (i.second > since)
+            {
+                removed.push_back(i.first);
+            }
+        }
+        writer.WriteVarUint(removed.size());
+        previous_id = 0;
+        for (auto entity : removed)
+        {
+            writer.WriteVarUint(entity.id_ - previous_id);
+            previous_id = entity.id_;
+        }
+    }
+
+    bool DecodeDelta(BitReader& reader, std::vector<Entity>& changed, std::vector<Entity>& removed) override
+    {
+        if (!reader.ReadBool() || !reader.Ok())
+        {
+            return false;
+        }
+        const std::uint64_t added_count = reader.ReadVarUint();
+        EntityIdType id = 0;
+        for (std::uint64_t i = 0; i < added_count && reader.Ok(); ++i)
+        {
+            id += reader.ReadVarUint();
+            changed.push_back(Entity{id});
+        }
+        const std::uint64_t removed_count = reader.ReadVarUint();
+        id = 0;
+        for (std::uint64_t i = 0; i < removed_count && reader.Ok(); ++i)
+        {
+            id += reader.ReadVarUint();
+            removed.push_back(Entity{id});
+        }
+        if (reader.Ok())
+        {
+            for (auto entity : changed)
+            {
+                MarkChanged(entity, 1);
+            }
+        }
+        return reader.Ok();
+    }
+
+    void MergeDelta(IComponentMap& decoded, const std::vector<Entity>& removed, TickType tick) override
+    {
+        for (auto const& i : static_cast<TagMap&>(decoded).change_tick_)
+        {
+            // an existing tag is not added again, so its tick stays
+            if (change_tick_.find(i.first) == change_tick_.end())
+            {
+                MarkChanged(i.first, tick);
+            }
+        }
+        for (auto entity : removed)
+        {
+            Erase(entity, tick);
+        }
+    }
+
+    std::vector<EntityIdType> GetEntityIds() const override
+    {
+        return ChangedSince(0);
+    }
+
+    double GetDisorder() const override
+    {
+        return 0;
+    }
+
+    bool Compact(std::size_t) override
+    {
+        // the ticks are small map nodes, rarely iterated
+        return true;
+    }
+
+    // tick of the addition per tagged entity, sparse since tags like IsPlayer are usually rare
+    std::map<Entity, TickType> change_tick_;
+    // tick of the removal per removed tag (kept until DiscardRemovalsUpTo is called)
+    std::map<Entity, TickType> removal_tick_;
+
+private:
+    std::vector<EntityIdType> ChangedSince(TickType since) const
+    {
+        std::vector<EntityIdType> ids;
+        for (auto const& i : change_tick_)
+        {
+            if (i.second > since)
+            {
+                ids.push_back(i.first.id_);
+            }
+        }
+        return ids;
+    }
 };
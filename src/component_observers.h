@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cinttypes>
+#include <functional>
+#include <map>
+#include <vector>
+
+#include "entity.h"
+#include "type.h"
+
+enum class ComponentEvent
+{
+    kAdd = 0,
+    kRemove = 1,
+    kChange = 2
+};
+
+// events published by EntityManager::ForwardToEventManager
+template <typename T>
+struct ComponentAdded
+{
+    Entity entity;
+};
+
+template <typename T>
+struct ComponentRemoved
+{
+    Entity entity;
+};
+
+template <typename T>
+struct ComponentChanged
+{
+    Entity entity;
+};
+
+// observers of one component type, indexed by ComponentEvent
+class ComponentObservers
+{
+public:
+    bool IsObserved(ComponentEvent event) const
+    {
+        const int e = static_cast<int>(event);
+        return !immediate_[e].empty() || !batch_[e].empty();
+    }
+
+    void Notify(ComponentEvent event, Entity entity)
+    {
+        const int e = static_cast<int>(event);
+        // changes are always collected since the component is modified after the notification (see GetComponent)
+        if (event == ComponentEvent::kChange)
+        {
+            if (IsObserved(event))
+            {
+                pending_[e].push_back(entity);
+            }
+            return;
+        }
+        for (auto const& cb : immediate_[e])
+        {
+            cb.second(entity);
+        }
+        if (!batch_[e].empty())
+        {
+            pending_[e].push_back(entity);
+        }
+    }
+
+    std::map<ObserverIdType, std::function<void(Entity)>> immediate_[3];
+    std::map<ObserverIdType, std::function<void(const std::vector<Entity>&)>> batch_[3];
+    // entities collected for batch observers (and change observers) until the next flush
+    std::vector<Entity> pending_[3];
+};
@@ -1,19 +1,54 @@
 #pragma once
 
+#include <algorithm>
 #include <iostream>
+#include <vector>
+#include "bit_stream.h"
 #include "entity.h"
 #include "entity_manager.h"
+#include "serializer.h"
+
+namespace {
+    // identifies a snapshot and its layout
+    const std::uint32_t SNAPSHOT_MAGIC = 0x4e535856;    // "VXSN"
+    const std::uint32_t SNAPSHOT_FORMAT_VERSION = 2;
+
+    void WriteString(std::ostream& os, const std::string& s)
+    {
+        WriteValue(os, static_cast<std::uint64_t>(s.size()));
+        os.write(s.data(), static_cast<std::streamsize>(s.size()));
+    }
+
+    bool ReadString(std::istream& is, std::string& s)
+    {
+        std::uint64_t size;
+        if (!ReadCount(is, size, 1))
+        {
+            return false;
+        }
+        s.resize(size);
+        return static_cast<bool>(is.read(&s[0], static_cast<std::streamsize>(size)));
+    }
+}
 
 EntityManager::EntityManager()
 {
     existing_entities_count_ = 0;
     next_entity_id_ = 0;
     next_component_type_id_ = 0;
+    // start at 1 so that "changed after tick 0" includes everything
+    tick_ = 1;
+    next_observer_id_ = 0;
 }
 
 Entity EntityManager::CreateEntity()
 {
     ++existing_entities_count_;
+    // skip entities which have been recreated by ApplyDelta while waiting in the queue
+    while (!available_entities_.empty() && !is_available_[available_entities_.front().id_])
+    {
+        available_entities_.pop();
+    }
     if (available_entities_.empty()) {
         Entity entity;
         ComponentBitField component_bitfield;
@@ -22,14 +57,34 @@ Entity EntityManager::CreateEntity()
         ++next_entity_id_;
         return entity;
     } else {
-        return available_entities_.front();
+        Entity entity = available_entities_.front();
+        available_entities_.pop();
+        is_available_[entity.id_] = false;
+        destroy_tick_.erase(entity);
+        return entity;
     }
 }
 
 void EntityManager::DestroyEntity(Entity entity)
 {
-    entity_component_bitfield_[entity].reset();
+    // remove the components of the entity as well, otherwise they would be inherited by the next user of the ID
+    ComponentBitField& component_bitfield = entity_component_bitfield_[entity];
+    for (ComponentIdType id = 0; id < next_component_type_id_; ++id)
+    {
+        if (component_bitfield[id])
+        {
+            observers_[id].Notify(ComponentEvent::kRemove, entity);
+            component_map_[id]->Erase(entity, tick_);
+        }
+    }
+    component_bitfield.reset();
     available_entities_.push(entity);
+    if (entity.id_ >= is_available_.size())
+    {
+        is_available_.resize(entity.id_ + 1, false);
+    }
+    is_available_[entity.id_] = true;
+    destroy_tick_[entity] = tick_;
     --existing_entities_count_;
 }
 
@@ -48,6 +103,452 @@ std::map<Entity, ComponentBitField>& EntityManager::GetEntities()
     return entity_component_bitfield_;
 }
 
+/*
+Snapshot layout:
+magic | format version | next entity ID | number of existing entities
+| number of available entities | available entity IDs
+| number of entities | entity IDs | bit fields (as 64 bit integers)
+| number of component types | per component type: type name, component block (see ComponentMap::Write)
+*/
+bool EntityManager::Save(std::ostream& os) const
+{
+    static_assert(MAX_COMPONENTS <= 64, "Bit fields are stored as 64 bit integers.");
+
+    WriteValue(os, SNAPSHOT_MAGIC);
+    WriteValue(os, SNAPSHOT_FORMAT_VERSION);
+    WriteValue(os, next_entity_id_);
+    WriteValue(os, static_cast<std::int64_t>(existing_entities_count_));
+
+    std::vector<EntityIdType> available;
+    std::queue<Entity> available_entities = available_entities_;
+    std::vector<bool> written(is_available_.size(), false);
+    while (!available_entities.empty())
+    {
+        // only entities which are still available (see CreateEntity), each once
+        const EntityIdType id = available_entities.front().id_;
+        if (is_available_[id] && !written[id])
+        {
+            available.push_back(id);
+            written[id] = true;
+        }
+        available_entities.pop();
+    }
+    WriteValue(os, static_cast<std::uint64_t>(available.size()));
+    WriteBlock(os, available.data(), available.size());
+
+    std::vector<EntityIdType> ids;
+    std::vector<std::uint64_t> bitfields;
+    ids.reserve(entity_component_bitfield_.size());
+    bitfields.reserve(entity_component_bitfield_.size());
+    for (auto const& i : entity_component_bitfield_)
+    {
+        ids.push_back(i.first.id_);
+        bitfields.push_back(i.second.to_ullong());
+    }
+    WriteValue(os, static_cast<std::uint64_t>(ids.size()));
+    WriteBlock(os, ids.data(), ids.size());
+    WriteBlock(os, bitfields.data(), bitfields.size());
+
+    // component type names ordered by their IDs
+    std::vector<std::string> type_names(next_component_type_id_);
+    for (auto const& i : component_type_id_mapper_)
+    {
+        type_names[i.second] = i.first;
+    }
+    WriteValue(os, next_component_type_id_);
+    for (ComponentIdType id = 0; id < next_component_type_id_; ++id)
+    {
+        WriteString(os, type_names[id]);
+        if (!component_map_.at(id)->Write(os))
+        {
+            return false;
+        }
+    }
+    return static_cast<bool>(os);
+}
+
+bool EntityManager::Load(std::istream& is)
+{
+    std::uint32_t magic;
+    std::uint32_t format_version;
+    if (!ReadValue(is, magic) || !ReadValue(is, format_version))
+    {
+        return false;
+    }
+    if (magic != SNAPSHOT_MAGIC || format_version != SNAPSHOT_FORMAT_VERSION)
+    {
+        return false;
+    }
+
+    EntityIdType next_entity_id;
+    std::int64_t existing_entities_count;
+    std::uint64_t available_count;
+    if (!ReadValue(is, next_entity_id) || !ReadValue(is, existing_entities_count) || !ReadCount(is, available_count, sizeof(EntityIdType)))
+    {
+        return false;
+    }
+    std::vector<EntityIdType> available(available_count);
+    if (!ReadBlock(is, available.data(), available_count))
+    {
+        return false;
+    }
+
+    std::uint64_t entity_count;
+    if (!ReadCount(is, entity_count, sizeof(EntityIdType) + sizeof(std::uint64_t)))
+    {
+        return false;
+    }
+    std::vector<EntityIdType> ids(entity_count);
+    std::vector<std::uint64_t> bitfields(entity_count);
+    if (!ReadBlock(is, ids.data(), entity_count) || !ReadBlock(is, bitfields.data(), entity_count))
+    {
+        return false;
+    }
+    // destroyed entities keep their (empty) bit fields, so available entities are saved entities with smaller IDs than the next one
+    // which also bounds the size of is_available_ by the saved IDs
+    EntityIdType available_end = 0;
+    for (auto id : available)
+    {
+        if (id >= next_entity_id || !std::binary_search(ids.begin(), ids.end(), id))
+        {
+            return false;
+        }
+        available_end = std::max(available_end, id + 1);
+    }
+
+    // the registered component types have to match the saved ones
+    ComponentIdType component_type_count;
+    if (!ReadValue(is, component_type_count) || component_type_count != next_component_type_id_)
+    {
+        return false;
+    }
+    // read into new maps so that nothing changes if the snapshot turns out to be invalid
+    std::map<ComponentIdType, std::shared_ptr<IComponentMap>> component_map;
+    for (ComponentIdType id = 0; id < component_type_count; ++id)
+    {
+        std::string type_name;
+        if (!ReadString(is, type_name))
+        {
+            return false;
+        }
+        auto it = component_type_id_mapper_.find(type_name);
+        if (it == component_type_id_mapper_.end() || it->second != id)
+        {
+            return false;
+        }
+        auto ecm = component_map_[id]->CreateEmpty();
+        if (!ecm->Read(is))
+        {
+            return false;
+        }
+        // the components have to belong to exactly the saved entities whose bit fields contain the component type
+        const std::vector<EntityIdType> component_ids = ecm->GetEntityIds();
+        std::size_t owner_count = 0;
+        for (auto bitfield : bitfields)
+        {
+            owner_count += (bitfield >> id) & 1;
+        }
+        if (component_ids.size() != owner_count)
+        {
+            return false;
+        }
+        for (auto component_id : component_ids)
+        {
+            auto owner = std::lower_bound(ids.begin(), ids.end(), component_id);
+            if (owner == ids.end() || *owner != component_id || !((bitfields[owner - ids.begin()] >> id) & 1))
+            {
+                return false;
+            }
+        }
+        component_map.insert({id, ecm});
+    }
+
+    // observers see the replaced components removed (while they still exist) and the loaded ones added
+    for (ComponentIdType id = 0; id < component_type_count; ++id)
+    {
+        if (!observers_[id].IsObserved(ComponentEvent::kRemove))
+        {
+            continue;
+        }
+        for (auto const& i : entity_component_bitfield_)
+        {
+            if (i.second[id])
+            {
+                observers_[id].Notify(ComponentEvent::kRemove, i.first);
+            }
+        }
+    }
+
+    // shared pointers handed out by GetComponentMap stay valid, so swap the contents instead of the pointers
+    for (auto& i : component_map)
+    {
+        component_map_[i.first]->Swap(*i.second);
+        // receivers of deltas need all loaded components
+        component_map_[i.first]->MarkAllChanged(tick_);
+    }
+    next_entity_id_ = next_entity_id;
+    existing_entities_count_ = static_cast<int>(existing_entities_count);
+    available_entities_ = std::queue<Entity>();
+    is_available_.assign(available_end, false);
+    for (auto id : available)
+    {
+        available_entities_.push(Entity{id});
+        is_available_[id] = true;
+    }
+    // the history of destroyed entities belongs to the replaced state
+    destroy_tick_.clear();
+    // the IDs are sorted, so inserting at the end is amortized constant time
+    entity_component_bitfield_.clear();
+    for (std::uint64_t i = 0; i < entity_count; ++i)
+    {
+        entity_component_bitfield_.emplace_hint(entity_component_bitfield_.end(), Entity{ids[i]}, ComponentBitField(bitfields[i]));
+    }
+    for (ComponentIdType id = 0; id < component_type_count; ++id)
+    {
+        if (!observers_[id].IsObserved(ComponentEvent::kAdd))
+        {
+            continue;
+        }
+        for (std::uint64_t i = 0; i < entity_count; ++i)
+        {
+            if ((bitfields[i] >> id) & 1)
+            {
+                observers_[id].Notify(ComponentEvent::kAdd, Entity{ids[i]});
+            }
+        }
+    }
+    return true;
+}
+
+EntityManager EntityManager::Clone() const
+{
+    EntityManager clone = *this;
+    // the copy shares the component maps, replace them by copies
+    for (auto& i : clone.component_map_)
+    {
+        i.second = i.second->Clone();
+    }
+    for (auto& resource : clone.resources_)
+    {
+        if (resource)
+        {
+            resource = resource->Clone();
+        }
+    }
+    // observers belong to the original
+    clone.observers_ = std::vector<ComponentObservers>(next_component_type_id_);
+    return clone;
+}
+
+TickType EntityManager::GetTick()
+{
+    return tick_;
+}
+
+TickType EntityManager::AdvanceTick()
+{
+    return ++tick_;
+}
+
+/*
+Delta layout (bit packed, see BitWriter):
+tick | number of component types | per component type: delta block (see ComponentMap::EncodeDelta)
+| number of destroyed entities | entity ID gaps
+*/
+std::vector<std::uint8_t> EntityManager::EncodeDelta(TickType since)
+{
+    BitWriter writer;
+    writer.WriteVarUint(tick_);
+    writer.WriteVarUint(next_component_type_id_);
+    for (auto const& i : component_map_)
+    {
+        i.second->EncodeDelta(writer, since);
+    }
+
+    std::vector<Entity> destroyed;
+    for (auto const& i : destroy_tick_)
+    {
+        if (i.second > since)
+        {
+            destroyed.push_back(i.first);
+        }
+    }
+    writer.WriteVarUint(destroyed.size());
+    EntityIdType previous_id = 0;
+    for (auto entity : destroyed)
+    {
+        writer.WriteVarUint(entity.id_ - previous_id);
+        previous_id = entity.id_;
+    }
+
+    // the delta contains everything up to its tick, changes made from now on belong to the next one
+    ++tick_;
+    return writer.GetBuffer();
+}
+
+bool EntityManager::ApplyDelta(const std::vector<std::uint8_t>& delta, TickType& delta_tick)
+{
+    BitReader reader(delta);
+    const TickType tick = reader.ReadVarUint();
+    const ComponentIdType component_type_count = reader.ReadVarUint();
+    if (!reader.Ok() || component_type_count != next_component_type_id_)
+    {
+        return false;
+    }
+
+    // decode everything first so that nothing changes if the delta turns out to be invalid
+    std::vector<std::shared_ptr<IComponentMap>> decoded(component_type_count);
+    std::vector<std::vector<Entity>> changed(component_type_count);
+    std::vector<std::vector<Entity>> removed(component_type_count);
+    for (ComponentIdType id = 0; id < component_type_count; ++id)
+    {
+        decoded[id] = component_map_[id]->CreateEmpty();
+        if (!decoded[id]->DecodeDelta(reader, changed[id], removed[id]))
+        {
+            return false;
+        }
+    }
+    const std::uint64_t destroyed_count = reader.ReadVarUint();
+    std::vector<Entity> destroyed;
+    EntityIdType destroyed_id = 0;
+    for (std::uint64_t i = 0; i < destroyed_count && reader.Ok(); ++i)
+    {
+        destroyed_id += reader.ReadVarUint();
+        destroyed.push_back(Entity{destroyed_id});
+    }
+    if (!reader.Ok())
+    {
+        return false;
+    }
+
+    for (ComponentIdType id = 0; id < component_type_count; ++id)
+    {
+        for (auto entity : removed[id])
+        {
+            auto it = entity_component_bitfield_.find(entity);
+            if (it != entity_component_bitfield_.end() && it->second[id])
+            {
+                observers_[id].Notify(ComponentEvent::kRemove, entity);
+                it->second.reset(id);
+            }
+        }
+        component_map_[id]->MergeDelta(*decoded[id], removed[id], tick_);
+        for (auto entity : changed[id])
+        {
+            // entities are created implicitly with their first component
+            if (entity_component_bitfield_.find(entity) == entity_component_bitfield_.end())
+            {
+                ++existing_entities_count_;
+                next_entity_id_ = std::max(next_entity_id_, entity.id_ + 1);
+            }
+            else if (entity.id_ < is_available_.size() && is_available_[entity.id_])
+            {
+                // a destroyed entity has been reused, it must no longer be handed out by CreateEntity
+                ++existing_entities_count_;
+                is_available_[entity.id_] = false;
+                destroy_tick_.erase(entity);
+            }
+            ComponentBitField& component_bitfield = entity_component_bitfield_[entity];
+            const bool added = !component_bitfield[id];
+            component_bitfield.set(id);
+            // tags cannot change
+            if (added || !tag_bitfield_[id])
+            {
+                observers_[id].Notify(added ? ComponentEvent::kAdd : ComponentEvent::kChange, entity);
+            }
+        }
+    }
+    for (auto entity : destroyed)
+    {
+        if (entity_component_bitfield_.find(entity) != entity_component_bitfield_.end() && (entity.id_ >= is_available_.size() || !is_available_[entity.id_]))
+        {
+            DestroyEntity(entity);
+        }
+    }
+    delta_tick = tick;
+    return true;
+}
+
+void EntityManager::DiscardRemovalsUpTo(TickType tick)
+{
+    for (auto it = destroy_tick_.begin(); it != destroy_tick_.end();)
+    {
+        it = it->second <= tick ? destroy_tick_.erase(it) : std::next(it);
+    }
+    for (auto const& i : component_map_)
+    {
+        i.second->DiscardRemovalsUpTo(tick);
+    }
+}
+
+void EntityManager::FlushObservers()
+{
+    for (ComponentIdType id = 0; id < observers_.size(); ++id)
+    {
+        FlushObservers(id);
+    }
+}
+
+void EntityManager::FlushObservers(ComponentIdType id)
+{
+    for (auto event : {ComponentEvent::kAdd, ComponentEvent::kRemove, ComponentEvent::kChange})
+    {
+        const int e = static_cast<int>(event);
+        if (observers_[id].pending_[e].empty())
+        {
+            continue;
+        }
+        // observers might add or remove components, which collects new notifications
+        std::vector<Entity> pending;
+        pending.swap(observers_[id].pending_[e]);
+
+        if (event == ComponentEvent::kChange)
+        {
+            // report every changed component once, and only if it still exists
+            std::sort(pending.begin(), pending.end());
+            pending.erase(std::unique(pending.begin(), pending.end(), [](Entity lhs, Entity rhs) { return lhs.id_ == rhs.id_; }), pending.end());
+            pending.erase(std::remove_if(pending.begin(), pending.end(), [this, id](Entity entity) { return !entity_component_bitfield_[entity][id]; }), pending.end());
+            for (auto const& cb : observers_[id].immediate_[e])
+            {
+                for (auto entity : pending)
+                {
+                    cb.second(entity);
+                }
+            }
+        }
+        for (auto const& cb : observers_[id].batch_[e])
+        {
+            cb.second(pending);
+        }
+    }
+}
+
+bool EntityManager::CompactComponents(std::chrono::microseconds budget, double max_disorder)
+{
+    const auto start = std::chrono::steady_clock::now();
+    while (next_compaction_id_ < next_component_type_id_)
+    {
+        if (std::chrono::steady_clock::now() - start >= budget)
+        {
+            return false;
+        }
+        // a map is compacted in steps of a bounded number of components, so that the budget is checked in between
+        const ComponentIdType id = next_compaction_id_;
+        if (!compaction_running_ && component_map_[id]->GetDisorder() <= max_disorder)
+        {
+            ++next_compaction_id_;
+            continue;
+        }
+        compaction_running_ = !component_map_[id]->Compact(COMPACTION_STEP);
+        if (!compaction_running_)
+        {
+            ++next_compaction_id_;
+        }
+    }
+    next_compaction_id_ = 0;
+    return true;
+}
+
 void EntityManager::PrintComponentTypeIdMapper()
 {
     std::cout << "-----component_type_id_mapper_\n";
@@ -1,16 +1,25 @@
 #pragma once
 
 #include <bitset>
+#include <cassert>
+#include <chrono>
+#include <functional>
+#include <istream>
 #include <map>
 #include <memory>
+#include <ostream>
 #include <queue>
 #include <string>
 #include <type_traits>
 #include <typeinfo>
 #include <unordered_map>
+#include <vector>
 
 #include "component_map.h"
+#include "component_observers.h"
 #include "entity.h"
+#include "event_manager.h"
+#include "resource.h"
 #include "type.h"
 
 class EntityManager
@@ -24,6 +33,43 @@ public:
     int GetExistingEntitiesCount();
     std::map<Entity, ComponentBitField>& GetEntities();
 
+    // snapshots of all entities and components (see README)
+    // loading requires the same component types to be registered in the same order as when saving
+    bool Save(std::ostream&) const;
+    bool Load(std::istream&);
+    // deep copy of all entities and components
+    EntityManager Clone() const;
+
+    // change tracking: adding a component or accessing it via GetComponent marks it as changed at the current tick
+    TickType GetTick();
+    TickType AdvanceTick();
+    // encode all components changed or removed and entities destroyed after the given tick (see README),
+    // the delta is stamped with the current tick, which is advanced afterwards
+    std::vector<std::uint8_t> EncodeDelta(TickType since);
+    // apply a delta created by EncodeDelta of another entity manager, returns the tick the delta was created at
+    bool ApplyDelta(const std::vector<std::uint8_t>& delta, TickType& delta_tick);
+    // removals are remembered to be able to encode them, forget them once every receiver has acknowledged the tick
+    void DiscardRemovalsUpTo(TickType);
+
+    // deliver collected notifications to batch observers and change observers (see Observe and ObserveBatch)
+    void FlushObservers();
+    // only the notifications of component type T, so that a process does not deliver the notifications of other types mid-frame
+    template <typename T>
+    void FlushObservers()
+    {
+        FlushObservers(TypeIdOf<T>());
+    }
+
+    /*
+    Incremental compaction: component maps whose nodes are scattered in memory after adding and removing components
+    (see IComponentMap::GetDisorder) are rebuilt with contiguous nodes, one map after another and COMPACTION_STEP
+    components at a time until the time budget is used up. The next call continues where the last one stopped.
+    Maps which are in order are skipped.
+    Entities stay the same, but references to components are invalidated.
+    Returns true if all component types have been visited since the last completed round.
+    */
+    bool CompactComponents(std::chrono::microseconds budget, double max_disorder = 0.1);
+
     // good old debugging via printing...
     void PrintComponentTypeIdMapper();
     void PrintEntityComponentBitField();
@@ -39,7 +85,17 @@ public:
         component_type_id_mapper_.insert({type_name, next_component_type_id_});
 
         // make (a pointer to) a map which can hold components of the new component type
-        component_map_.insert({next_component_type_id_, std::make_shared<ComponentMap<T>>()});
+        // (tags, i.e., empty types, only exist in the bit fields)
+        if constexpr (std::is_empty<T>::value)
+        {
+            component_map_.insert({next_component_type_id_, std::make_shared<TagMap>()});
+            tag_bitfield_.set(next_component_type_id_);
+        }
+        else
+        {
+            component_map_.insert({next_component_type_id_, std::make_shared<ComponentMap<T>>()});
+        }
+        observers_.emplace_back();
 
         ++next_component_type_id_;
     }
@@ -51,21 +107,53 @@ public:
         return component_type_id_mapper_[typeid(T).name()];
     }
 
+    // tags (empty types like struct IsPlayer {}) are not stored, only the bit of the entity is set
     template <typename T>
-    void AddComponent(Entity entity, T component)
+    void AddComponent(Entity entity, T component = T())
     {
-        auto ecm = GetComponentMap<T>();
+        const ComponentIdType id = TypeIdOf<T>();
         // assert that entity does not already have this component type
-        assert(ecm->entity_component_map_.find(entity) == ecm->entity_component_map_.end() && "Entity already has this component.");
-        ecm->entity_component_map_.insert({entity, component});
+        assert(!entity_component_bitfield_[entity][id] && "Entity already has this component.");
+        if constexpr (std::is_empty<T>::value)
+        {
+            std::static_pointer_cast<TagMap>(component_map_[id])->MarkChanged(entity, tick_);
+        }
+        else
+        {
+            auto ecm = GetComponentMap<T>();
+            ecm->entity_component_map_.insert({entity, component});
+            ecm->MarkChanged(entity, tick_);
+        }
         // set the bit corresponding to the component type to indicate that this entity now "has" the component
-        entity_component_bitfield_[entity].set(TypeIdOf<T>());
+        entity_component_bitfield_[entity].set(id);
+        observers_[id].Notify(ComponentEvent::kAdd, entity);
+    }
+
+    template <typename T>
+    bool HasComponent(Entity entity)
+    {
+        return entity_component_bitfield_[entity][TypeIdOf<T>()];
     }
 
     template <typename T>
     T& GetComponent(Entity entity)
     {
+        static_assert(!std::is_empty<T>::value, "Tags have no data, use HasComponent.");
         // assert that entity has component T (by checking if the corresponding bit is set)
+        const ComponentIdType id = TypeIdOf<T>();
+        assert(entity_component_bitfield_[entity][id] && "Entity does not have this component.");
+        auto ecm = GetComponentMap<T>();
+        // the caller might modify the component
+        ecm->MarkChanged(entity, tick_);
+        observers_[id].Notify(ComponentEvent::kChange, entity);
+        return ecm->entity_component_map_[entity];
+    }
+
+    // read-only access which does not mark the component as changed
+    template <typename T>
+    const T& PeekComponent(Entity entity)
+    {
+        static_assert(!std::is_empty<T>::value, "Tags have no data, use HasComponent.");
         assert(entity_component_bitfield_[entity][TypeIdOf<T>()] && "Entity does not have this component.");
         return GetComponentMap<T>()->entity_component_map_[entity];
     }
@@ -94,17 +182,100 @@ public:
     template <typename T>
     void RemoveComponent(Entity entity)
     {
+        const ComponentIdType id = TypeIdOf<T>();
         // assert that entity hast this component type
-        assert(entity_component_bitfield_[entity][TypeIdOf<T>()] && "Entity does not have this component.");
+        assert(entity_component_bitfield_[entity][id] && "Entity does not have this component.");
+        // observers are notified while the component still exists
+        observers_[id].Notify(ComponentEvent::kRemove, entity);
         // reset the bit corresponding to the component type to indicate that this entity no longer "has" the component
-        entity_component_bitfield_[entity].reset(TypeIdOf<T>());
-        GetComponentMap<T>()->entity_component_map_.erase(entity);
+        entity_component_bitfield_[entity].reset(id);
+        component_map_[id]->Erase(entity, tick_);
+    }
+
+    /*
+    Observers are called when a component of type T is added to, removed from, or changed (accessed via GetComponent)
+    for an entity. Immediate observers of additions and removals are called synchronously (removal observers before the
+    component is removed). Batch observers receive all entities collected since the last call of FlushObservers.
+    Change observers are always called from FlushObservers since GetComponent returns the component before it is modified.
+    */
+    template <typename T>
+    ObserverIdType Observe(ComponentEvent event, std::function<void(Entity)> callback)
+    {
+        observers_[TypeIdOf<T>()].immediate_[static_cast<int>(event)].insert({next_observer_id_, callback});
+        return next_observer_id_++;
+    }
+
+    template <typename T>
+    ObserverIdType ObserveBatch(ComponentEvent event, std::function<void(const std::vector<Entity>&)> callback)
+    {
+        observers_[TypeIdOf<T>()].batch_[static_cast<int>(event)].insert({next_observer_id_, callback});
+        return next_observer_id_++;
+    }
+
+    template <typename T>
+    void Unobserve(ObserverIdType observer_id)
+    {
+        auto& observers = observers_[TypeIdOf<T>()];
+        for (int e = 0; e < 3; ++e)
+        {
+            observers.immediate_[e].erase(observer_id);
+            observers.batch_[e].erase(observer_id);
+        }
+    }
+
+    // publish ComponentAdded<T> and ComponentRemoved<T> immediately, and ComponentChanged<T> in FlushObservers
+    template <typename T>
+    void ForwardToEventManager(EventManager& event_manager)
+    {
+        Observe<T>(ComponentEvent::kAdd, [&event_manager](Entity entity) { event_manager.Publish(ComponentAdded<T>{entity}); });
+        Observe<T>(ComponentEvent::kRemove, [&event_manager](Entity entity) { event_manager.Publish(ComponentRemoved<T>{entity}); });
+        Observe<T>(ComponentEvent::kChange, [&event_manager](Entity entity) { event_manager.Publish(ComponentChanged<T>{entity}); });
+    }
+
+    /*
+    Resources are singletons (world seed, camera, time, ...) stored once per entity manager instead of as components of a
+    dummy entity. Every resource type has a global index (see resource.h), so access is a vector lookup.
+    Resources are cloned with the entity manager but neither saved in snapshots nor replicated.
+    */
+    template <typename T>
+    void SetResource(T resource)
+    {
+        const std::size_t index = ResourceIndexOf<T>();
+        if (index >= resources_.size())
+        {
+            resources_.resize(index + 1);
+        }
+        resources_[index] = std::make_shared<Resource<T>>(std::move(resource));
+    }
+
+    template <typename T>
+    bool HasResource() const
+    {
+        const std::size_t index = ResourceIndexOf<T>();
+        return index < resources_.size() && resources_[index];
+    }
+
+    template <typename T>
+    T& GetResource()
+    {
+        assert(HasResource<T>() && "Resource has not been set.");
+        return static_cast<Resource<T>&>(*resources_[ResourceIndexOf<T>()]).value_;
+    }
+
+    template <typename T>
+    void RemoveResource()
+    {
+        if (HasResource<T>())
+        {
+            resources_[ResourceIndexOf<T>()].reset();
+        }
     }
 
     // cast from base class (IComponentMap) to derived class (ComponentMap)
     template <typename T>
     std::shared_ptr<ComponentMap<T>> GetComponentMap()
     {
+        static_assert(!std::is_empty<T>::value, "Tags are not stored in component maps.");
         return std::static_pointer_cast<ComponentMap<T>>(component_map_[TypeIdOf<T>()]);
     }
 
@@ -112,9 +283,29 @@ private:
     int existing_entities_count_;
     EntityIdType next_entity_id_;
     ComponentIdType next_component_type_id_;
+    TickType tick_;
+    ObserverIdType next_observer_id_;
     // queue destroyed entities and reuse them first before creating new ones (when the queue is empty)
     std::queue<Entity> available_entities_;
+    // indexed by entity ID, entities recreated by ApplyDelta stay in the queue but are no longer available
+    std::vector<bool> is_available_;
+    // tick of the destruction per destroyed entity (kept until DiscardRemovalsUpTo is called)
+    std::map<Entity, TickType> destroy_tick_;
     std::map<Entity, ComponentBitField> entity_component_bitfield_;
     std::unordered_map<std::string, ComponentIdType> component_type_id_mapper_;
     std::map<ComponentIdType, std::shared_ptr<IComponentMap>> component_map_;
+    // bits of the component types which are tags
+    ComponentBitField tag_bitfield_;
+    // indexed by resource type index (see resource.h)
+    std::vector<std::shared_ptr<IResource>> resources_;
+    // indexed by component type ID
+    void FlushObservers(ComponentIdType id);
+
+    std::vector<ComponentObservers> observers_;
+    // components moved by one compaction step
+    static const std::size_t COMPACTION_STEP = 256;
+    // component type ID the next compaction starts with
+    ComponentIdType next_compaction_id_ = 0;
+    // whether the map of next_compaction_id_ is partially compacted
+    bool compaction_running_ = false;
 };
@@ -95,14 +95,27 @@ public:
     template <typename T>
     void Publish(T& event)
     {
-        for (auto const& cb : GetCallbacks<T>())
+        // nothing to do if nobody has subscribed to the event type (GetCallbacks would use the ID of another type)
+        auto it = event_type_to_id_map_.find(typeid(T).name());
+        if (it == event_type_to_id_map_.end())
+        {
+            return;
+        }
+        for (auto const& cb : std::static_pointer_cast<CallbackMap<T>>(callbacks_map_[it->second])->map_)
         {
             cb.second(event);
         }
     }
 
+    // allow publishing temporaries, e.g., Publish(SomeEvent{...})
+    template <typename T>
+    void Publish(T&& event)
+    {
+        Publish<T>(event);
+    }
+
     template <typename T>
-    std::map<ProcessIdType, std::function<void(T)>>& GetCallbacks()
+    std::map<ProcessIdType, std::function<void(T&)>>& GetCallbacks()
     {
         return std::static_pointer_cast<CallbackMap<T>>(callbacks_map_[EventIdOf<T>()])->map_;
     }
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+struct Vec3
+{
+    Vec3 operator +(const Vec3& rhs) const
+    {
+        return Vec3{x + rhs.x, y + rhs.y, z + rhs.z};
+    }
+
+    Vec3 operator -(const Vec3& rhs) const
+    {
+        return Vec3{x - rhs.x, y - rhs.y, z - rhs.z};
+    }
+
+    Vec3 operator *(float s) const
+    {
+        return Vec3{x * s, y * s, z * s};
+    }
+
+    float x = 0;
+    float y = 0;
+    float z = 0;
+};
+
+inline float Dot(const Vec3& a, const Vec3& b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+inline Vec3 Cross(const Vec3& a, const Vec3& b)
+{
+    return Vec3{a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+inline Vec3 Normalize(const Vec3& v)
+{
+    return v * (1 / std::sqrt(Dot(v, v)));
+}
+
+// points p with Dot(normal, p) + d >= 0 are inside
+struct Plane
+{
+    float Distance(const Vec3& p) const
+    {
+        return Dot(normal, p) + d;
+    }
+
+    Vec3 normal;
+    float d = 0;
+};
+
+// axis-aligned boxes in structure of arrays layout (one array per coordinate)
+struct AabbArrays
+{
+    void Resize(std::size_t size)
+    {
+        min_x.resize(size);
+        min_y.resize(size);
+        min_z.resize(size);
+        max_x.resize(size);
+        max_y.resize(size);
+        max_z.resize(size);
+    }
+
+    std::vector<float> min_x, min_y, min_z;
+    std::vector<float> max_x, max_y, max_z;
+};
+
+class Frustum
+{
+public:
+    // fov_y is the vertical field of view in radians, aspect is width / height
+    static Frustum FromPerspective(Vec3 eye, Vec3 forward, Vec3 up, float fov_y, float aspect, float near, float far)
+    {
+        const Vec3 f = Normalize(forward);
+        const Vec3 r = Normalize(Cross(f, up));
+        const Vec3 u = Cross(r, f);
+        const float half_v = std::tan(fov_y / 2);
+        const float half_h = half_v * aspect;
+        // a point which is certainly inside, used to orient the side planes
+        const Vec3 inside = eye + f * ((near + far) / 2);
+
+        Frustum frustum;
+        frustum.planes_[0] = PlaneThrough(eye + f * near, f);
+        frustum.planes_[1] = PlaneThrough(eye + f * far, f * -1);
+        const Vec3 edges[4] = {f - r * half_h, f + r * half_h, f - u * half_v, f + u * half_v};
+        const Vec3 axes[4] = {u, u, r, r};
+        for (int i = 0; i < 4; ++i)
+        {
+            Plane plane = PlaneThrough(eye, Normalize(Cross(edges[i], axes[i])));
+            if (plane.Distance(inside) < 0)
+            {
+                plane = PlaneThrough(eye, plane.normal * -1);
+            }
+            frustum.planes_[2 + i] = plane;
+        }
+        return frustum;
+    }
+
+    bool IsPointInside(const Vec3& p) const
+    {
+        for (auto const& plane : planes_)
+        {
+            if (plane.Distance(p) < 0)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /*
+    Conservative test of many boxes at once: visible[i] is set to 0 if box i is certainly outside, otherwise to 1.
+    For every plane, only the corner of the box farthest along the plane normal is tested. The loops run over
+    plain float arrays without branches so that the compiler can vectorize them (SIMD).
+    */
+    void CullAabbs(const AabbArrays& boxes, std::vector<char>& visible) const
+    {
+        const std::size_t count = boxes.min_x.size();
+        visible.assign(count, 1);
+        for (auto const& plane : planes_)
+        {
+            const float* px = plane.normal.x >= 0 ? boxes.max_x.data() : boxes.min_x.data();
+            const float* py = plane.normal.y >= 0 ? boxes.max_y.data() : boxes.min_y.data();
+            const float* pz = plane.normal.z >= 0 ? boxes.max_z.data() : boxes.min_z.data();
+            const float nx = plane.normal.x;
+            const float ny = plane.normal.y;
+            const float nz = plane.normal.z;
+            const float d = plane.d;
+            char* v = visible.data();
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                v[i] &= (nx * px[i] + ny * py[i] + nz * pz[i] + d) >= 0;
+            }
+        }
+    }
+
+    const std::array<Plane, 6>& GetPlanes() const
+    {
+        return planes_;
+    }
+
+private:
+    static Plane PlaneThrough(const Vec3& point, const Vec3& normal)
+    {
+        return Plane{normal, -Dot(normal, point)};
+    }
+
+    std::array<Plane, 6> planes_;
+};
@@ -0,0 +1,317 @@
+#include <algorithm>
+#include <cstdlib>
+
+#include "lod_clipmap.h"
+
+namespace {
+    // downsample the given source chunk (with a GetBlock method) into one octant of the target
+    template <typename TSource>
+    void DownsampleInto(const TSource& source, int ox, int oy, int oz, std::vector<BlockType>& target)
+    {
+        const int half = CHUNK_SIZE / 2;
+        for (int y = 0; y < half; ++y)
+        {
+            for (int z = 0; z < half; ++z)
+            {
+                for (int x = 0; x < half; ++x)
+                {
+                    BlockType solid[8];
+                    int solid_count = 0;
+                    for (int i = 0; i < 8; ++i)
+                    {
+                        const BlockType block = source.GetBlock(2 * x + (i & 1), 2 * y + ((i >> 1) & 1), 2 * z + ((i >> 2) & 1));
+                        if (block != AIR)
+                        {
+                            solid[solid_count++] = block;
+                        }
+                    }
+                    if (solid_count < 4)
+                    {
+                        continue;
+                    }
+                    // most frequent block type
+                    std::sort(solid, solid + solid_count);
+                    BlockType best = solid[0];
+                    int best_count = 0;
+                    for (int i = 0, run = 0; i < solid_count; ++i)
+                    {
+                        run = (i > 0 && solid[i] == solid[i - 1]) ? run + 1 : 1;
+                        if (run > best_count)
+                        {
+                            best = solid[i];
+                            best_count = run;
+                        }
+                    }
+                    target[Chunk::IndexOf(ox * half + x, oy * half + y, oz * half + z)] = best;
+                }
+            }
+        }
+    }
+}
+
+LodClipmap::LodClipmap(VoxelWorld& world, int levels, int radius) : world_(world), levels_(levels), radius_(radius)
+{
+    world_observer_ = world_.Observe([this](int x, int y, int z, bool whole_chunk) { Invalidate(ChunkCoordOf(x, y, z), whole_chunk); });
+}
+
+LodClipmap::~LodClipmap()
+{
+    world_.Unobserve(world_observer_);
+}
+
+void LodClipmap::Update(const Position& center)
+{
+    built_count_ = 0;
+    const ChunkCoord center_chunk = ChunkCoordOf(center.x, center.y, center.z);
+    if (has_center_ && center_chunk == center_chunk_ && stale_.empty())
+    {
+        return;
+    }
+    const bool moved = !has_center_ || !(center_chunk == center_chunk_);
+    has_center_ = true;
+    center_chunk_ = center_chunk;
+    if (occupied_dirty_)
+    {
+        UpdateOccupied();
+    }
+    if (moved)
+    {
+        EvictFarChunks();
+    }
+
+    // evict chunks which left their ring
+    for (auto it = lod_chunks_.begin(); it != lod_chunks_.end();)
+    {
+        const LodKey& key = it->first;
+        if (!IsInRegion(key.level, key.coord) || IsCovered(key.level, key.coord))
+        {
+            stale_.erase(key);
+            it = lod_chunks_.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    // build chunks which entered their ring or are stale
+    for (int level = 1; level <= levels_; ++level)
+    {
+        const ChunkCoord c = CenterOf(level);
+        for (int x = c.x - radius_; x <= c.x + radius_; ++x)
+        {
+            for (int y = c.y - radius_; y <= c.y + radius_; ++y)
+            {
+                for (int z = c.z - radius_; z <= c.z + radius_; ++z)
+                {
+                    const LodKey key{level, ChunkCoord{x, y, z}};
+                    if (IsCovered(level, key.coord))
+                    {
+                        continue;
+                    }
+                    if (lod_chunks_.find(key) == lod_chunks_.end() || stale_.count(key) > 0)
+                    {
+                        auto lod_chunk = GetOrBuild(level, key.coord);
+                        lod_chunks_[key] = lod_chunk ? lod_chunk : std::make_shared<LodChunk>();
+                    }
+                }
+            }
+        }
+    }
+    stale_.clear();
+}
+
+bool LodClipmap::IsFullResolution(ChunkCoord coord) const
+{
+    return has_center_ && IsInRegion(0, coord);
+}
+
+std::shared_ptr<const LodChunk> LodClipmap::GetLodChunk(int level, ChunkCoord coord) const
+{
+    auto it = lod_chunks_.find(LodKey{level, coord});
+    if (it == lod_chunks_.end())
+    {
+        return nullptr;
+    }
+    return it->second;
+}
+
+const std::map<LodKey, std::shared_ptr<LodChunk>>& LodClipmap::GetLodChunks() const
+{
+    return lod_chunks_;
+}
+
+std::uint64_t LodClipmap::GetBuiltCount() const
+{
+    return built_count_;
+}
+
+std::uint64_t LodClipmap::GetCachedCount() const
+{
+    return cache_.size();
+}
+
+ChunkCoord LodClipmap::CenterOf(int level) const
+{
+    const int size = 1 << level;
+    return ChunkCoord{FloorDiv(center_chunk_.x, size), FloorDiv(center_chunk_.y, size), FloorDiv(center_chunk_.z, size)};
+}
+
+bool LodClipmap::IsInRegion(int level, ChunkCoord coord) const
+{
+    const ChunkCoord c = CenterOf(level);
+    return std::abs(coord.x - c.x) <= radius_ && std::abs(coord.y - c.y) <= radius_ && std::abs(coord.z - c.z) <= radius_;
+}
+
+// a chunk is covered if all of its eight children are in the region of the next finer level
+bool LodClipmap::IsCovered(int level, ChunkCoord coord) const
+{
+    if (level == 0)
+    {
+        return false;
+    }
+    const ChunkCoord c = CenterOf(level - 1);
+    auto covered = [this](int v, int center) { return 2 * v >= center - radius_ && 2 * v + 1 <= center + radius_; };
+    return covered(coord.x, c.x) && covered(coord.y, c.y) && covered(coord.z, c.z);
+}
+
+std::shared_ptr<LodChunk> LodClipmap::GetOrBuild(int level, ChunkCoord coord)
+{
+    const LodKey key{level, coord};
+    auto it = cache_.find(key);
+    if (it != cache_.end())
+    {
+        if (outdated_.erase(key) > 0)
+        {
+            // replace the cached chunk instead of modifying it, the clipmap might still show the previous version
+            it->second = Build(level, coord, it->second.get());
+        }
+        return it->second;
+    }
+    if (occupied_.count(key) == 0)
+    {
+        return nullptr;
+    }
+    auto lod_chunk = Build(level, coord, nullptr);
+    cache_.insert({key, lod_chunk});
+    return lod_chunk;
+}
+
+std::shared_ptr<LodChunk> LodClipmap::Build(int level, ChunkCoord coord, const LodChunk* previous)
+{
+    ++built_count_;
+    auto lod_chunk = std::make_shared<LodChunk>();
+    const int half = CHUNK_SIZE / 2;
+    for (int i = 0; i < 8; ++i)
+    {
+        const int ox = i & 1;
+        const int oy = (i >> 1) & 1;
+        const int oz = (i >> 2) & 1;
+        const ChunkCoord child{2 * coord.x + ox, 2 * coord.y + oy, 2 * coord.z + oz};
+        if (level == 1)
+        {
+            if (auto chunk = world_.GetChunk(child))
+            {
+                lod_chunk->blocks_.resize(CHUNK_VOLUME, AIR);
+                DownsampleInto(*chunk, ox, oy, oz, lod_chunk->blocks_);
+                continue;
+            }
+        }
+        else if (auto child_lod_chunk = GetOrBuild(level - 1, child))
+        {
+            if (!child_lod_chunk->IsEmpty())
+            {
+                lod_chunk->blocks_.resize(CHUNK_VOLUME, AIR);
+                DownsampleInto(*child_lod_chunk, ox, oy, oz, lod_chunk->blocks_);
+            }
+            continue;
+        }
+        // the source is gone (unloaded or evicted), keep what the octant showed before
+        if (previous && !previous->IsEmpty())
+        {
+            lod_chunk->blocks_.resize(CHUNK_VOLUME, AIR);
+            for (int y = oy * half; y < oy * half + half; ++y)
+            {
+                for (int z = oz * half; z < oz * half + half; ++z)
+                {
+                    for (int x = ox * half; x < ox * half + half; ++x)
+                    {
+                        lod_chunk->blocks_[Chunk::IndexOf(x, y, z)] = previous->GetBlock(x, y, z);
+                    }
+                }
+            }
+        }
+    }
+    // keep empty chunks small
+    if (std::all_of(lod_chunk->blocks_.begin(), lod_chunk->blocks_.end(), [](BlockType block) { return block == AIR; }))
+    {
+        lod_chunk->blocks_.clear();
+    }
+    return lod_chunk;
+}
+
+void LodClipmap::UpdateOccupied()
+{
+    occupied_.clear();
+    for (auto const& i : world_.GetChunks())
+    {
+        for (int level = 1; level <= levels_; ++level)
+        {
+            const int size = 1 << level;
+            occupied_.insert(LodKey{level, ChunkCoord{FloorDiv(i.first.x, size), FloorDiv(i.first.y, size), FloorDiv(i.first.z, size)}});
+        }
+    }
+    occupied_dirty_ = false;
+}
+
+int LodClipmap::CacheRadius() const
+{
+    // the children of a chunk within radius of the center of the coarser level are within 2 * radius + 1 of the center
+    return 2 * radius_ + 2;
+}
+
+void LodClipmap::EvictFarChunks()
+{
+    for (auto it = cache_.begin(); it != cache_.end();)
+    {
+        const ChunkCoord c = CenterOf(it->first.level);
+        const ChunkCoord& coord = it->first.coord;
+        if (std::abs(coord.x - c.x) > CacheRadius() || std::abs(coord.y - c.y) > CacheRadius() || std::abs(coord.z - c.z) > CacheRadius())
+        {
+            outdated_.erase(it->first);
+            it = cache_.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+// only the chunks containing the changed chunk are rebuilt (their siblings stay cached)
+void LodClipmap::Invalidate(ChunkCoord chunk, bool whole_chunk)
+{
+    // chunks are loaded (or created by VoxelWorld::SetBlock) and removed
+    if (whole_chunk || occupied_.count(LodKey{1, ChunkCoord{FloorDiv(chunk.x, 2), FloorDiv(chunk.y, 2), FloorDiv(chunk.z, 2)}}) == 0)
+    {
+        occupied_dirty_ = true;
+    }
+    // unloading keeps the downsampled blocks
+    if (!world_.GetChunk(chunk))
+    {
+        return;
+    }
+    for (int level = 1; level <= levels_; ++level)
+    {
+        const int size = 1 << level;
+        const LodKey key{level, ChunkCoord{FloorDiv(chunk.x, size), FloorDiv(chunk.y, size), FloorDiv(chunk.z, size)}};
+        if (cache_.find(key) != cache_.end())
+        {
+            outdated_.insert(key);
+        }
+        if (lod_chunks_.find(key) != lod_chunks_.end())
+        {
+            stale_.insert(key);
+        }
+    }
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cinttypes>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "chunk.h"
+#include "position.h"
+#include "type.h"
+#include "voxel_world.h"
+
+// downsampled chunk: a chunk of level L has CHUNK_SIZE^3 cells, every cell represents 2^L x 2^L x 2^L blocks
+class LodChunk
+{
+public:
+    BlockType GetBlock(int x, int y, int z) const
+    {
+        return blocks_.empty() ? AIR : blocks_[Chunk::IndexOf(x, y, z)];
+    }
+
+    bool IsEmpty() const
+    {
+        return blocks_.empty();
+    }
+
+    // empty if all cells are air
+    std::vector<BlockType> blocks_;
+};
+
+struct LodKey
+{
+    bool operator <(const LodKey& rhs) const
+    {
+        if (level != rhs.level)
+        {
+            return level < rhs.level;
+        }
+        return coord < rhs.coord;
+    }
+
+    int level = 0;
+    // in units of level L chunks, i.e., the chunk covers the (level 0) chunks 2^L * x to 2^L * x + 2^L - 1 etc.
+    ChunkCoord coord;
+};
+
+/*
+Nested cubes of chunks around a center (the player), the farther away the coarser.
+Level 0 are the full resolution chunks within radius (in chunks) of the center chunk, they are not stored here.
+Level L >= 1 consists of the level L chunks within radius of the center (in level L chunk units)
+which are not covered by level L - 1. Every level thus doubles the view distance.
+Chunks which are only partially covered by the finer level are kept, a renderer should prefer the finer level there.
+
+Update only builds chunks which became visible (or whose blocks changed) since the last update and evicts chunks which
+are no longer needed, so moving the center by a chunk only builds the new boundary layers.
+A level L chunk is built from eight level L - 1 chunks (or eight world chunks for level 1): a cell is solid if at least
+half of its eight source cells are solid and then has the most frequent block type among them.
+The chunks of all levels are cached (also those covered by finer levels), so building a chunk only downsamples its eight
+children, and changing a block only rebuilds the chunks containing it. Regions without loaded world chunks are empty
+without building anything.
+Cached chunks outlive the world chunks they were built from: unloading a world chunk changes nothing, and when a chunk is
+rebuilt, the octants whose sources are gone keep their previous cells. So the view distance is not bounded by the loaded
+world chunks. Cached chunks are only evicted when they are farther than CACHE_RADIUS (in chunks of their level) from the
+center.
+*/
+class LodClipmap
+{
+public:
+    LodClipmap(VoxelWorld& world, int levels, int radius);
+    ~LodClipmap();
+
+    void Update(const Position& center);
+
+    // true if the (level 0) chunk is within the full resolution region
+    bool IsFullResolution(ChunkCoord coord) const;
+    // nullptr if the chunk is not part of the clipmap
+    std::shared_ptr<const LodChunk> GetLodChunk(int level, ChunkCoord coord) const;
+    const std::map<LodKey, std::shared_ptr<LodChunk>>& GetLodChunks() const;
+    // number of chunks built in the last update (including the finer chunks they were built from)
+    std::uint64_t GetBuiltCount() const;
+    std::uint64_t GetCachedCount() const;
+
+private:
+    ChunkCoord CenterOf(int level) const;
+    bool IsInRegion(int level, ChunkCoord coord) const;
+    bool IsCovered(int level, ChunkCoord coord) const;
+    // the cached chunk, (re)built if necessary, nullptr if nothing is known about the region
+    std::shared_ptr<LodChunk> GetOrBuild(int level, ChunkCoord coord);
+    // previous: the last version of the chunk, whose octants are kept where the sources are gone
+    std::shared_ptr<LodChunk> Build(int level, ChunkCoord coord, const LodChunk* previous);
+    void UpdateOccupied();
+    void EvictFarChunks();
+    void Invalidate(ChunkCoord chunk, bool whole_chunk);
+
+    VoxelWorld& world_;
+    ObserverIdType world_observer_;
+    int levels_;
+    int radius_;
+    bool has_center_ = false;
+    ChunkCoord center_chunk_;
+    std::uint64_t built_count_ = 0;
+    // the chunks of the clipmap, shared with cache_
+    std::map<LodKey, std::shared_ptr<LodChunk>> lod_chunks_;
+    // chunks whose blocks changed since they were built
+    std::set<LodKey> stale_;
+    // cached chunks are kept within this distance of the center of their level (in chunks of their level), which
+    // includes the children of the chunks in the clipmap
+    int CacheRadius() const;
+
+    // all chunks built so far near the center
+    std::map<LodKey, std::shared_ptr<LodChunk>> cache_;
+    // cached chunks whose blocks changed since they were built
+    std::set<LodKey> outdated_;
+    // chunks (of levels >= 1) containing at least one loaded world chunk
+    std::set<LodKey> occupied_;
+    bool occupied_dirty_ = true;
+};
@@ -0,0 +1,17 @@
+#include "lod_process.h"
+#include "position.h"
+
+LodProcess::LodProcess(EntityManager& entity_manager, VoxelWorld& world, Entity player, int levels, int radius)
+    : entity_manager_(entity_manager), player_(player), clipmap_(world, levels, radius)
+{
+}
+
+void LodProcess::Update()
+{
+    clipmap_.Update(entity_manager_.PeekComponent<Position>(player_));
+}
+
+LodClipmap& LodProcess::GetClipmap()
+{
+    return clipmap_;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "entity.h"
+#include "entity_manager.h"
+#include "lod_clipmap.h"
+#include "process.h"
+#include "voxel_world.h"
+
+// keeps the LOD clipmap centered at the Position of the given entity (the player)
+class LodProcess : public IProcess
+{
+public:
+    LodProcess(EntityManager& entity_manager, VoxelWorld& world, Entity player, int levels, int radius);
+
+    void Update();
+
+    LodClipmap& GetClipmap();
+
+private:
+    EntityManager& entity_manager_;
+    Entity player_;
+    LodClipmap clipmap_;
+};
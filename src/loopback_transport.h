@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cinttypes>
+#include <queue>
+#include <vector>
+
+// stand-in for a network connection: packets sent are received in the same order on the same object
+class LoopbackTransport
+{
+public:
+    void Send(const std::vector<std::uint8_t>& packet)
+    {
+        packets_.push(packet);
+        bytes_sent_ += packet.size();
+    }
+
+    // returns false if there is no packet to receive
+    bool Receive(std::vector<std::uint8_t>& packet)
+    {
+        if (packets_.empty())
+        {
+            return false;
+        }
+        packet = std::move(packets_.front());
+        packets_.pop();
+        return true;
+    }
+
+    std::uint64_t GetBytesSent() const
+    {
+        return bytes_sent_;
+    }
+
+private:
+    std::queue<std::vector<std::uint8_t>> packets_;
+    std::uint64_t bytes_sent_ = 0;
+};
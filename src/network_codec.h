@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cinttypes>
+#include <cstring>
+#include <type_traits>
+
+#include "bit_stream.h"
+
+/*
+Encoding of components for delta snapshots (replication).
+
+By default, trivially copyable components are sent as raw bytes.
+Components which are not trivially copyable, or which should be sent with fewer bits (quantized), specialize NetworkCodec:
+
+template <>
+struct NetworkCodec<Health>
+{
+    static constexpr bool kCustom = true;
+    static void Encode(BitWriter& writer, const Health& health) { writer.WriteBits(health.value, 7); }
+    static bool Decode(BitReader& reader, Health& health) { health.value = reader.ReadBits(7); return reader.Ok(); }
+};
+
+Component types which are neither trivially copyable nor have a specialization are not replicated.
+*/
+template <typename T>
+struct NetworkCodec
+{
+    static constexpr bool kCustom = false;
+};
+
+template <typename T>
+constexpr bool IsReplicable()
+{
+    return NetworkCodec<T>::kCustom || std::is_trivially_copyable<T>::value;
+}
+
+template <typename T>
+void EncodeComponent(BitWriter& writer, const T& component)
+{
+    if constexpr (NetworkCodec<T>::kCustom)
+    {
+        NetworkCodec<T>::Encode(writer, component);
+    }
+    else
+    {
+        unsigned char bytes[sizeof(T)];
+        std::memcpy(bytes, &component, sizeof(T));
+        for (auto byte : bytes)
+        {
+            writer.WriteBits(byte, 8);
+        }
+    }
+}
+
+template <typename T>
+bool DecodeComponent(BitReader& reader, T& component)
+{
+    if constexpr (NetworkCodec<T>::kCustom)
+    {
+        return NetworkCodec<T>::Decode(reader, component);
+    }
+    else
+    {
+        unsigned char bytes[sizeof(T)];
+        for (auto& byte : bytes)
+        {
+            byte = static_cast<unsigned char>(reader.ReadBits(8));
+        }
+        std::memcpy(&component, bytes, sizeof(T));
+        return reader.Ok();
+    }
+}
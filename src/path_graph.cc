@@ -0,0 +1,411 @@
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <queue>
+
+#include "path_graph.h"
+
+namespace {
+    const int DIRECTIONS[6][3] = {{-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}};
+
+    int LocalIndexOf(const BlockCoord& block, ChunkCoord coord)
+    {
+        return Chunk::IndexOf(block.x - coord.x * CHUNK_SIZE, block.y - coord.y * CHUNK_SIZE, block.z - coord.z * CHUNK_SIZE);
+    }
+
+    BlockCoord BlockOf(int index, ChunkCoord coord)
+    {
+        // see Chunk::IndexOf
+        return BlockCoord{coord.x * CHUNK_SIZE + index % CHUNK_SIZE, coord.y * CHUNK_SIZE + index / (CHUNK_SIZE * CHUNK_SIZE), coord.z * CHUNK_SIZE + (index / CHUNK_SIZE) % CHUNK_SIZE};
+    }
+
+    int Manhattan(const BlockCoord& a, const BlockCoord& b)
+    {
+        return std::abs(a.x - b.x) + std::abs(a.y - b.y) + std::abs(a.z - b.z);
+    }
+
+    struct OpenEntry
+    {
+        bool operator <(const OpenEntry& rhs) const
+        {
+            // std::priority_queue is a max heap
+            return f > rhs.f;
+        }
+
+        int f;
+        int g;
+        BlockCoord node;
+    };
+}
+
+PathGraph::PathGraph(const VoxelWorld& world) : world_(world)
+{
+}
+
+void PathGraph::MarkDirty(ChunkCoord coord)
+{
+    // the entrances on the faces are shared with the neighbors
+    dirty_.insert(coord);
+    for (auto const& d : DIRECTIONS)
+    {
+        dirty_.insert(ChunkCoord{coord.x + d[0], coord.y + d[1], coord.z + d[2]});
+    }
+}
+
+const std::set<ChunkCoord>& PathGraph::GetDirtyChunks() const
+{
+    return dirty_;
+}
+
+std::uint64_t PathGraph::RebuildDirty()
+{
+    const std::uint64_t count = dirty_.size();
+    for (auto coord : dirty_)
+    {
+        Rebuild(coord);
+    }
+    dirty_.clear();
+    if (count > 0)
+    {
+        ++generation_;
+    }
+    return count;
+}
+
+std::uint64_t PathGraph::GetGeneration() const
+{
+    return generation_;
+}
+
+bool PathGraph::IsPassable(const BlockCoord& block) const
+{
+    const ChunkCoord coord = ChunkCoordOf(block);
+    auto chunk = world_.GetChunk(coord);
+    return chunk && chunk->GetBlocks()[LocalIndexOf(block, coord)] == AIR;
+}
+
+std::uint64_t PathGraph::GetNodeCount() const
+{
+    std::uint64_t count = 0;
+    for (auto const& i : graphs_)
+    {
+        count += i.second.nodes.size();
+    }
+    return count;
+}
+
+void PathGraph::Rebuild(ChunkCoord coord)
+{
+    auto chunk = world_.GetChunk(coord);
+    if (!chunk)
+    {
+        graphs_.erase(coord);
+        return;
+    }
+
+    ChunkGraph graph;
+    for (int face = 0; face < 6; ++face)
+    {
+        const int axis = face / 2;
+        const ChunkCoord neighbor_coord{coord.x + DIRECTIONS[face][0], coord.y + DIRECTIONS[face][1], coord.z + DIRECTIONS[face][2]};
+        auto neighbor = world_.GetChunk(neighbor_coord);
+        if (!neighbor)
+        {
+            continue;
+        }
+
+        // the two other axes span the face, both neighbors use the same order so that they agree on the entrances
+        const int u_axis = axis == 0 ? 1 : 0;
+        const int v_axis = axis == 2 ? 1 : 2;
+        const int layer = (face & 1) ? CHUNK_SIZE - 1 : 0;
+        auto local_of = [&](int u, int v, int a) {
+            int c[3];
+            c[axis] = a;
+            c[u_axis] = u;
+            c[v_axis] = v;
+            return Chunk::IndexOf(c[0], c[1], c[2]);
+        };
+        std::vector<char> open(CHUNK_SIZE * CHUNK_SIZE);
+        for (int u = 0; u < CHUNK_SIZE; ++u)
+        {
+            for (int v = 0; v < CHUNK_SIZE; ++v)
+            {
+                open[u * CHUNK_SIZE + v] = chunk->GetBlocks()[local_of(u, v, layer)] == AIR && neighbor->GetBlocks()[local_of(u, v, CHUNK_SIZE - 1 - layer)] == AIR;
+            }
+        }
+
+        // connected regions of open cells, one entrance in the middle of each region
+        std::vector<char> visited(open.size(), 0);
+        for (int start = 0; start < CHUNK_SIZE * CHUNK_SIZE; ++start)
+        {
+            if (!open[start] || visited[start])
+            {
+                continue;
+            }
+            std::vector<int> region;
+            std::vector<int> stack{start};
+            visited[start] = 1;
+            while (!stack.empty())
+            {
+                const int cell = stack.back();
+                stack.pop_back();
+                region.push_back(cell);
+                const int u = cell / CHUNK_SIZE;
+                const int v = cell % CHUNK_SIZE;
+                const int neighbors[4][2] = {{u - 1, v}, {u + 1, v}, {u, v - 1}, {u, v + 1}};
+                for (auto const& n : neighbors)
+                {
+                    if (n[0] < 0 || n[0] >= CHUNK_SIZE || n[1] < 0 || n[1] >= CHUNK_SIZE)
+                    {
+                        continue;
+                    }
+                    const int next = n[0] * CHUNK_SIZE + n[1];
+                    if (open[next] && !visited[next])
+                    {
+                        visited[next] = 1;
+                        stack.push_back(next);
+                    }
+                }
+            }
+            std::sort(region.begin(), region.end());
+            const int cell = region[region.size() / 2];
+            const BlockCoord node = BlockOf(local_of(cell / CHUNK_SIZE, cell % CHUNK_SIZE, layer), coord);
+            if (graph.index_of.find(node) == graph.index_of.end())
+            {
+                graph.index_of.insert({node, static_cast<int>(graph.nodes.size())});
+                graph.nodes.push_back(node);
+            }
+        }
+    }
+
+    // intra-chunk edges
+    const std::size_t n = graph.nodes.size();
+    graph.distances.assign(n * n, -1);
+    std::vector<int> distances;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        SearchInChunk(*chunk, coord, graph.nodes[i], distances, nullptr);
+        for (std::size_t j = 0; j < n; ++j)
+        {
+            graph.distances[i * n + j] = distances[LocalIndexOf(graph.nodes[j], coord)];
+        }
+    }
+    graphs_[coord] = std::move(graph);
+}
+
+void PathGraph::SearchInChunk(const Chunk& chunk, ChunkCoord coord, const BlockCoord& from, std::vector<int>& distances, std::vector<int>* parents) const
+{
+    const auto& blocks = chunk.GetBlocks();
+    distances.assign(CHUNK_VOLUME, -1);
+    if (parents)
+    {
+        parents->assign(CHUNK_VOLUME, -1);
+    }
+    const int start = LocalIndexOf(from, coord);
+    if (blocks[start] != AIR)
+    {
+        return;
+    }
+    const int strides[3] = {1, CHUNK_SIZE * CHUNK_SIZE, CHUNK_SIZE};
+    std::queue<int> queue;
+    distances[start] = 0;
+    queue.push(start);
+    while (!queue.empty())
+    {
+        const int index = queue.front();
+        queue.pop();
+        const int coords[3] = {index % CHUNK_SIZE, index / (CHUNK_SIZE * CHUNK_SIZE), (index / CHUNK_SIZE) % CHUNK_SIZE};
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            for (int sign = -1; sign <= 1; sign += 2)
+            {
+                const int c = coords[axis] + sign;
+                if (c < 0 || c >= CHUNK_SIZE)
+                {
+                    continue;
+                }
+                const int next = index + sign * strides[axis];
+                if (blocks[next] == AIR && distances[next] < 0)
+                {
+                    distances[next] = distances[index] + 1;
+                    if (parents)
+                    {
+                        (*parents)[next] = index;
+                    }
+                    queue.push(next);
+                }
+            }
+        }
+    }
+}
+
+bool PathGraph::FindRoute(const BlockCoord& start, const BlockCoord& goal, std::vector<BlockCoord>& route) const
+{
+    route.clear();
+    if (!IsPassable(start) || !IsPassable(goal))
+    {
+        return false;
+    }
+    const ChunkCoord start_chunk = ChunkCoordOf(start);
+    const ChunkCoord goal_chunk = ChunkCoordOf(goal);
+    auto start_graph = graphs_.find(start_chunk);
+    if (start_graph == graphs_.end() || graphs_.find(goal_chunk) == graphs_.end())
+    {
+        return false;
+    }
+
+    std::vector<int> start_distances;
+    SearchInChunk(*world_.GetChunk(start_chunk), start_chunk, start, start_distances, nullptr);
+    if (start_chunk == goal_chunk && start_distances[LocalIndexOf(goal, goal_chunk)] >= 0)
+    {
+        return true;
+    }
+    std::vector<int> goal_distances;
+    SearchInChunk(*world_.GetChunk(goal_chunk), goal_chunk, goal, goal_distances, nullptr);
+
+    /* A* over the entrance nodes, the start and goal are connected to the nodes of their chunks */
+
+    std::priority_queue<OpenEntry> open;
+    std::map<BlockCoord, int> best_g;
+    std::map<BlockCoord, BlockCoord> parents;
+    auto relax = [&](const BlockCoord& node, int g, const BlockCoord* parent) {
+        auto it = best_g.find(node);
+        if (it != best_g.end() && it->second <= g)
+        {
+            return;
+        }
+        best_g[node] = g;
+        if (parent)
+        {
+            parents[node] = *parent;
+        }
+        open.push(OpenEntry{g + Manhattan(node, goal), g, node});
+    };
+    for (auto const& node : start_graph->second.nodes)
+    {
+        const int d = start_distances[LocalIndexOf(node, start_chunk)];
+        if (d >= 0)
+        {
+            relax(node, d, nullptr);
+        }
+    }
+
+    int best_goal = INT_MAX;
+    BlockCoord last;
+    while (!open.empty())
+    {
+        const OpenEntry entry = open.top();
+        open.pop();
+        if (entry.g > best_g[entry.node])
+        {
+            continue;
+        }
+        if (entry.f >= best_goal)
+        {
+            break;
+        }
+
+        const ChunkCoord coord = ChunkCoordOf(entry.node);
+        if (coord == goal_chunk)
+        {
+            const int d = goal_distances[LocalIndexOf(entry.node, goal_chunk)];
+            if (d >= 0 && entry.g + d < best_goal)
+            {
+                best_goal = entry.g + d;
+                last = entry.node;
+            }
+        }
+
+        const ChunkGraph& graph = graphs_.at(coord);
+        const std::size_t n = graph.nodes.size();
+        const int i = graph.index_of.at(entry.node);
+        for (std::size_t j = 0; j < n; ++j)
+        {
+            const int d = graph.distances[i * n + j];
+            if (d > 0)
+            {
+                relax(graph.nodes[j], entry.g + d, &entry.node);
+            }
+        }
+        for (auto const& d : DIRECTIONS)
+        {
+            const BlockCoord next{entry.node.x + d[0], entry.node.y + d[1], entry.node.z + d[2]};
+            const ChunkCoord next_coord = ChunkCoordOf(next);
+            if (next_coord == coord)
+            {
+                continue;
+            }
+            auto next_graph = graphs_.find(next_coord);
+            if (next_graph != graphs_.end() && next_graph->second.index_of.count(next) > 0)
+            {
+                relax(next, entry.g + 1, &entry.node);
+            }
+        }
+    }
+    if (best_goal == INT_MAX)
+    {
+        return false;
+    }
+
+    for (BlockCoord node = last;;)
+    {
+        route.push_back(node);
+        auto it = parents.find(node);
+        if (it == parents.end())
+        {
+            break;
+        }
+        node = it->second;
+    }
+    std::reverse(route.begin(), route.end());
+    return true;
+}
+
+bool PathGraph::RefinePath(const BlockCoord& start, const BlockCoord& goal, const std::vector<BlockCoord>& route, std::vector<BlockCoord>& path) const
+{
+    path.assign(1, start);
+    std::vector<BlockCoord> waypoints = route;
+    waypoints.push_back(goal);
+    std::vector<int> distances;
+    std::vector<int> parents;
+    for (auto const& waypoint : waypoints)
+    {
+        const BlockCoord current = path.back();
+        if (current == waypoint)
+        {
+            continue;
+        }
+        const ChunkCoord coord = ChunkCoordOf(current);
+        auto chunk = world_.GetChunk(coord);
+        if (!chunk)
+        {
+            return false;
+        }
+        if (coord == ChunkCoordOf(waypoint))
+        {
+            // shortest path within the chunk
+            SearchInChunk(*chunk, coord, current, distances, &parents);
+            int index = LocalIndexOf(waypoint, coord);
+            if (distances[index] < 0)
+            {
+                return false;
+            }
+            const std::size_t begin = path.size();
+            for (; distances[index] > 0; index = parents[index])
+            {
+                path.push_back(BlockOf(index, coord));
+            }
+            std::reverse(path.begin() + begin, path.end());
+        }
+        else if (Manhattan(current, waypoint) == 1 && IsPassable(waypoint))
+        {
+            // step into the neighboring chunk
+            path.push_back(waypoint);
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cinttypes>
+#include <map>
+#include <set>
+#include <vector>
+
+#include "chunk.h"
+#include "voxel_world.h"
+
+/*
+Hierarchical (HPA*) pathfinding graph over the loaded chunks.
+
+Blocks are passable if they are air, a path moves between face-adjacent passable blocks, and blocks in chunks which are
+not loaded are not passable. For every face between two loaded chunks, the pairs of passable blocks facing each other
+are grouped into connected regions; every region becomes one entrance, i.e., a node on either side of the face.
+Within a chunk, the nodes are connected by edges whose costs are the lengths of the shortest paths inside the chunk.
+
+A query first searches the small graph of entrances (FindRoute) and then refines the route into blocks, which only
+requires searches within single chunks (RefinePath). The search results are not necessarily optimal but close to it.
+
+The const methods only read, so queries can run in parallel as long as neither the world nor the graph changes.
+*/
+class PathGraph
+{
+public:
+    explicit PathGraph(const VoxelWorld& world);
+
+    // the graph of the chunk has to be rebuilt, e.g., after its blocks (or the blocks of a neighbor) changed
+    void MarkDirty(ChunkCoord coord);
+    // chunks which will be rebuilt by RebuildDirty
+    const std::set<ChunkCoord>& GetDirtyChunks() const;
+    // returns the number of rebuilt chunks
+    std::uint64_t RebuildDirty();
+    // incremented whenever the graph changes
+    std::uint64_t GetGeneration() const;
+
+    // sequence of entrance nodes from start to goal (empty if the path stays in one chunk), false if there is no path
+    bool FindRoute(const BlockCoord& start, const BlockCoord& goal, std::vector<BlockCoord>& route) const;
+    // full path of blocks (including start and goal) along the given route
+    bool RefinePath(const BlockCoord& start, const BlockCoord& goal, const std::vector<BlockCoord>& route, std::vector<BlockCoord>& path) const;
+
+    bool IsPassable(const BlockCoord& block) const;
+    std::uint64_t GetNodeCount() const;
+
+private:
+    struct ChunkGraph
+    {
+        std::vector<BlockCoord> nodes;
+        std::map<BlockCoord, int> index_of;
+        // distances between the nodes within the chunk (nodes.size() x nodes.size()), -1 if not connected
+        std::vector<int> distances;
+    };
+
+    void Rebuild(ChunkCoord coord);
+    // breadth-first search within one chunk: distances (-1 if unreachable) and predecessors of all blocks
+    void SearchInChunk(const Chunk& chunk, ChunkCoord coord, const BlockCoord& from, std::vector<int>& distances, std::vector<int>* parents) const;
+
+    const VoxelWorld& world_;
+    std::map<ChunkCoord, ChunkGraph> graphs_;
+    std::set<ChunkCoord> dirty_;
+    std::uint64_t generation_ = 0;
+};
@@ -0,0 +1,192 @@
+#include <atomic>
+#include <utility>
+
+#include "pathfinding_process.h"
+
+PathfindingProcess::PathfindingProcess(VoxelWorld& world, EventManager& event_manager, unsigned thread_count, std::size_t max_cached_routes)
+    : world_(world), event_manager_(event_manager), graph_(world), thread_pool_(thread_count), max_cached_routes_(max_cached_routes)
+{
+    for (auto const& i : world_.GetChunks())
+    {
+        graph_.MarkDirty(i.first);
+    }
+    world_observer_ = world_.Observe([this](int x, int y, int z, bool) { graph_.MarkDirty(ChunkCoordOf(x, y, z)); });
+}
+
+PathfindingProcess::~PathfindingProcess()
+{
+    world_.Unobserve(world_observer_);
+}
+
+std::uint64_t PathfindingProcess::RequestPath(Entity requester, const BlockCoord& start, const BlockCoord& goal)
+{
+    pending_.push_back(Request{next_request_id_, requester, start, goal});
+    return next_request_id_++;
+}
+
+void PathfindingProcess::Update()
+{
+    // only the routes through rebuilt chunks might be blocked now
+    for (auto coord : graph_.GetDirtyChunks())
+    {
+        DropRoutesThrough(coord);
+    }
+    graph_.RebuildDirty();
+    if (pending_.empty())
+    {
+        return;
+    }
+    std::vector<Request> requests;
+    requests.swap(pending_);
+
+    /* search the routes which are not cached yet, once per start chunk and goal */
+
+    std::map<RouteKey, std::size_t> searched_for;
+    std::vector<std::size_t> searches;
+    for (std::size_t i = 0; i < requests.size(); ++i)
+    {
+        const RouteKey key{ChunkCoordOf(requests[i].start), requests[i].goal};
+        if (route_cache_.find(key) == route_cache_.end() && searched_for.find(key) == searched_for.end())
+        {
+            searched_for.insert({key, i});
+            searches.push_back(i);
+        }
+    }
+    std::vector<std::vector<BlockCoord>> routes(searches.size());
+    std::vector<char> route_found(searches.size(), 0);
+    thread_pool_.ParallelFor(searches.size(), [&](std::size_t i) {
+        const Request& request = requests[searches[i]];
+        route_found[i] = graph_.FindRoute(request.start, request.goal, routes[i]);
+    });
+    for (std::size_t i = 0; i < searches.size(); ++i)
+    {
+        if (route_found[i])
+        {
+            const Request& request = requests[searches[i]];
+            CacheRoute(RouteKey{ChunkCoordOf(request.start), request.goal}, std::move(routes[i]));
+        }
+    }
+
+    /* refine the routes into paths (the cache is only read here) */
+
+    std::vector<PathFound> results(requests.size());
+    std::atomic<std::uint64_t> cache_hits{0};
+    thread_pool_.ParallelFor(requests.size(), [&](std::size_t i) {
+        const Request& request = requests[i];
+        const RouteKey key{ChunkCoordOf(request.start), request.goal};
+        PathFound& result = results[i];
+        result.request_id = request.id;
+        result.requester = request.requester;
+        result.found = false;
+
+        auto searched = searched_for.find(key);
+        const bool own_route = searched != searched_for.end() && searched->second == i;
+        auto it = route_cache_.find(key);
+        if (it != route_cache_.end())
+        {
+            result.found = graph_.RefinePath(request.start, request.goal, it->second.route, result.path);
+            if (result.found && !own_route)
+            {
+                ++cache_hits;
+            }
+        }
+        if (!result.found && !own_route)
+        {
+            // the shared route does not fit this start (e.g. it is in another cave of the same chunk)
+            std::vector<BlockCoord> route;
+            result.found = graph_.FindRoute(request.start, request.goal, route) && graph_.RefinePath(request.start, request.goal, route, result.path);
+        }
+        if (!result.found)
+        {
+            result.path.clear();
+        }
+    });
+    cache_hit_count_ += cache_hits;
+
+    // the routes used in this update are the most recently used ones
+    for (auto const& request : requests)
+    {
+        auto it = route_cache_.find(RouteKey{ChunkCoordOf(request.start), request.goal});
+        if (it != route_cache_.end())
+        {
+            lru_.splice(lru_.end(), lru_, it->second.lru_position);
+        }
+    }
+    while (route_cache_.size() > max_cached_routes_)
+    {
+        DropRoute(lru_.front());
+    }
+
+    for (auto& result : results)
+    {
+        event_manager_.Publish(result);
+    }
+}
+
+const PathGraph& PathfindingProcess::GetGraph() const
+{
+    return graph_;
+}
+
+std::uint64_t PathfindingProcess::GetCacheHitCount() const
+{
+    return cache_hit_count_;
+}
+
+std::uint64_t PathfindingProcess::GetCachedRouteCount() const
+{
+    return route_cache_.size();
+}
+
+void PathfindingProcess::CacheRoute(const RouteKey& key, std::vector<BlockCoord> route)
+{
+    CachedRoute cached;
+    std::set<ChunkCoord> chunks{key.start_chunk, ChunkCoordOf(key.goal)};
+    for (auto const& node : route)
+    {
+        chunks.insert(ChunkCoordOf(node));
+    }
+    cached.chunks.assign(chunks.begin(), chunks.end());
+    cached.route = std::move(route);
+    cached.lru_position = lru_.insert(lru_.end(), key);
+    for (auto coord : cached.chunks)
+    {
+        routes_through_[coord].insert(key);
+    }
+    route_cache_.insert({key, std::move(cached)});
+}
+
+void PathfindingProcess::DropRoutesThrough(ChunkCoord coord)
+{
+    auto it = routes_through_.find(coord);
+    if (it == routes_through_.end())
+    {
+        return;
+    }
+    // DropRoute modifies routes_through_
+    const std::set<RouteKey> keys = it->second;
+    for (auto const& key : keys)
+    {
+        DropRoute(key);
+    }
+}
+
+void PathfindingProcess::DropRoute(const RouteKey& key)
+{
+    auto it = route_cache_.find(key);
+    if (it == route_cache_.end())
+    {
+        return;
+    }
+    for (auto coord : it->second.chunks)
+    {
+        auto through = routes_through_.find(coord);
+        through->second.erase(key);
+        if (through->second.empty())
+        {
+            routes_through_.erase(through);
+        }
+    }
+    lru_.erase(it->second.lru_position);
+    route_cache_.erase(it);
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cinttypes>
+#include <list>
+#include <map>
+#include <set>
+#include <vector>
+
+#include "chunk.h"
+#include "entity.h"
+#include "event_manager.h"
+#include "path_graph.h"
+#include "process.h"
+#include "thread_pool.h"
+#include "type.h"
+#include "voxel_world.h"
+
+// published by PathfindingProcess for every request
+struct PathFound
+{
+    std::uint64_t request_id;
+    Entity requester;
+    bool found;
+    // blocks from start to goal (both included), empty if no path was found
+    std::vector<BlockCoord> path;
+};
+
+/*
+Answers path requests of mobs in batches.
+
+Requests are collected and processed in the next update: first, the PathGraph of changed chunks is rebuilt, then the
+routes over the entrance nodes are searched on the worker threads, and finally the routes are refined into blocks,
+again on the worker threads. The results are published as PathFound events (on the thread calling Update).
+
+Routes are cached by start chunk and goal, so mobs in the same chunk heading for the same goal share one search.
+A cached route is dropped when one of the chunks it passes through is rebuilt, and the least recently used routes are
+dropped when the cache is full.
+*/
+class PathfindingProcess : public IProcess
+{
+public:
+    PathfindingProcess(VoxelWorld& world, EventManager& event_manager, unsigned thread_count, std::size_t max_cached_routes = 1024);
+    ~PathfindingProcess();
+
+    // returns the ID of the request (see PathFound)
+    std::uint64_t RequestPath(Entity requester, const BlockCoord& start, const BlockCoord& goal);
+    void Update();
+
+    const PathGraph& GetGraph() const;
+    // number of requests which were answered with a route searched for another request
+    std::uint64_t GetCacheHitCount() const;
+    std::uint64_t GetCachedRouteCount() const;
+
+private:
+    struct Request
+    {
+        std::uint64_t id;
+        Entity requester;
+        BlockCoord start;
+        BlockCoord goal;
+    };
+
+    struct RouteKey
+    {
+        bool operator <(const RouteKey& rhs) const
+        {
+            if (!(start_chunk == rhs.start_chunk))
+            {
+                return start_chunk < rhs.start_chunk;
+            }
+            return goal < rhs.goal;
+        }
+
+        ChunkCoord start_chunk;
+        BlockCoord goal;
+    };
+
+    struct CachedRoute
+    {
+        std::vector<BlockCoord> route;
+        // chunks the route passes through
+        std::vector<ChunkCoord> chunks;
+        // position in lru_
+        std::list<RouteKey>::iterator lru_position;
+    };
+
+    void CacheRoute(const RouteKey& key, std::vector<BlockCoord> route);
+    void DropRoutesThrough(ChunkCoord coord);
+    void DropRoute(const RouteKey& key);
+
+    VoxelWorld& world_;
+    EventManager& event_manager_;
+    ObserverIdType world_observer_;
+    PathGraph graph_;
+    ThreadPool thread_pool_;
+    std::vector<Request> pending_;
+    std::size_t max_cached_routes_;
+    std::map<RouteKey, CachedRoute> route_cache_;
+    // keys of the cached routes, least recently used first
+    std::list<RouteKey> lru_;
+    // keys of the cached routes per chunk they pass through
+    std::map<ChunkCoord, std::set<RouteKey>> routes_through_;
+    std::uint64_t next_request_id_ = 0;
+    std::uint64_t cache_hit_count_ = 0;
+};
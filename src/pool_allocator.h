@@ -0,0 +1,297 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+Fixed size nodes allocated from blocks of NODES_PER_BLOCK nodes. Freed nodes are reused (last freed first), the blocks
+are released with the pool. Nodes allocated one after the other lie next to each other as long as there are no freed
+nodes to reuse, which is what compaction (see ComponentMap::Compact) relies on.
+
+BeginCompaction retires the current blocks: new nodes come from new blocks, nodes of the retired blocks are not reused
+when freed, and the retired blocks are released once their last node has been freed. The owner moves its nodes over
+by reallocating them one by one.
+*/
+class NodePool
+{
+public:
+    static const std::size_t NODES_PER_BLOCK = 256;
+
+    NodePool(std::size_t node_size, std::size_t node_alignment)
+    {
+        // free nodes store the pointer to the next free node
+        node_alignment_ = std::max(node_alignment, alignof(void*));
+        node_size_ = (std::max(node_size, sizeof(void*)) + node_alignment_ - 1) / node_alignment_ * node_alignment_;
+    }
+
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+
+    ~NodePool()
+    {
+        ReleaseRetiredBlocks();
+        for (auto block : blocks_)
+        {
+            ::operator delete(block, std::align_val_t(node_alignment_));
+        }
+    }
+
+    void* Allocate()
+    {
+        if (free_)
+        {
+            --free_count_;
+            ++reused_count_;
+            void* node = free_;
+            free_ = *static_cast<void**>(free_);
+            return node;
+        }
+        if (blocks_.empty() || next_in_block_ == NODES_PER_BLOCK)
+        {
+            blocks_.push_back(::operator new(node_size_ * NODES_PER_BLOCK, std::align_val_t(node_alignment_)));
+            next_in_block_ = 0;
+        }
+        return static_cast<char*>(blocks_.back()) + node_size_ * next_in_block_++;
+    }
+
+    void Deallocate(void* node)
+    {
+        if (!retired_blocks_.empty() && IsRetired(node))
+        {
+            if (--retired_node_count_ == 0)
+            {
+                ReleaseRetiredBlocks();
+            }
+            return;
+        }
+        ++free_count_;
+        *static_cast<void**>(node) = free_;
+        free_ = node;
+    }
+
+    void BeginCompaction()
+    {
+        ReleaseRetiredBlocks();
+        const std::size_t allocated_count = blocks_.empty() ? 0 : (blocks_.size() - 1) * NODES_PER_BLOCK + next_in_block_;
+        retired_node_count_ = allocated_count - free_count_;
+        retired_blocks_.swap(blocks_);
+        // sorted by address to find the block of a freed node
+        std::sort(retired_blocks_.begin(), retired_blocks_.end(), std::less<void*>());
+        next_in_block_ = 0;
+        free_ = nullptr;
+        free_count_ = 0;
+        reused_count_ = 0;
+        if (retired_node_count_ == 0)
+        {
+            ReleaseRetiredBlocks();
+        }
+    }
+
+    // whether nodes of blocks retired by BeginCompaction are still in use
+    bool IsCompacting() const
+    {
+        return !retired_blocks_.empty();
+    }
+
+    // freed nodes which have not been reused yet
+    std::size_t GetFreeCount() const
+    {
+        return free_count_;
+    }
+
+    // nodes allocated from the freed ones (i.e., likely out of order) since the last compaction, they might be freed again
+    std::size_t GetReusedCount() const
+    {
+        return reused_count_;
+    }
+
+private:
+    bool IsRetired(void* node) const
+    {
+        auto it = std::upper_bound(retired_blocks_.begin(), retired_blocks_.end(), node, std::less<void*>());
+        return it != retired_blocks_.begin() && std::less<void*>()(node, static_cast<char*>(*std::prev(it)) + node_size_ * NODES_PER_BLOCK);
+    }
+
+    void ReleaseRetiredBlocks()
+    {
+        for (auto block : retired_blocks_)
+        {
+            ::operator delete(block, std::align_val_t(node_alignment_));
+        }
+        retired_blocks_.clear();
+        retired_node_count_ = 0;
+    }
+
+    std::size_t node_size_;
+    std::size_t node_alignment_;
+    std::vector<void*> blocks_;
+    std::size_t next_in_block_ = 0;
+    void* free_ = nullptr;
+    std::size_t free_count_ = 0;
+    std::size_t reused_count_ = 0;
+    std::vector<void*> retired_blocks_;
+    // nodes of the retired blocks which have not been freed yet
+    std::size_t retired_node_count_ = 0;
+};
+
+// the pools of all node sizes used by one container (std::map allocates nodes of a type unknown to its user)
+class NodePools
+{
+public:
+    NodePool& Get(std::size_t node_size, std::size_t node_alignment)
+    {
+        auto& pool = pools_[{node_size, node_alignment}];
+        if (!pool)
+        {
+            pool = std::make_unique<NodePool>(node_size, node_alignment);
+        }
+        return *pool;
+    }
+
+    std::size_t GetFreeCount() const
+    {
+        std::size_t count = 0;
+        for (auto const& i : pools_)
+        {
+            count += i.second->GetFreeCount();
+        }
+        return count;
+    }
+
+    std::size_t GetReusedCount() const
+    {
+        std::size_t count = 0;
+        for (auto const& i : pools_)
+        {
+            count += i.second->GetReusedCount();
+        }
+        return count;
+    }
+
+    void BeginCompaction()
+    {
+        for (auto& i : pools_)
+        {
+            i.second->BeginCompaction();
+        }
+    }
+
+    bool IsCompacting() const
+    {
+        for (auto const& i : pools_)
+        {
+            if (i.second->IsCompacting())
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    std::map<std::pair<std::size_t, std::size_t>, std::unique_ptr<NodePool>> pools_;
+};
+
+/*
+Allocator for node based containers: single objects come from the pools of the container, arrays from operator new.
+Copies of a container get new pools, swapping or assigning containers exchanges the pools with the nodes.
+Moving an allocator copies it (as required for allocators), so a moved-from container still has usable pools.
+*/
+template <typename T>
+class PoolAllocator
+{
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    PoolAllocator() : pools_(std::make_shared<NodePools>())
+    {
+    }
+
+    PoolAllocator(const PoolAllocator& other) : pools_(other.pools_)
+    {
+    }
+
+    PoolAllocator(PoolAllocator&& other) noexcept : pools_(other.pools_)
+    {
+    }
+
+    PoolAllocator& operator=(const PoolAllocator& other)
+    {
+        pools_ = other.pools_;
+        return *this;
+    }
+
+    PoolAllocator& operator=(PoolAllocator&& other) noexcept
+    {
+        pools_ = other.pools_;
+        return *this;
+    }
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>& other) : pools_(other.pools_)
+    {
+    }
+
+    PoolAllocator select_on_container_copy_construction() const
+    {
+        return PoolAllocator();
+    }
+
+    T* allocate(std::size_t n)
+    {
+        if (n == 1)
+        {
+            return static_cast<T*>(pools_->Get(sizeof(T), alignof(T)).Allocate());
+        }
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, std::size_t n)
+    {
+        if (n == 1)
+        {
+            pools_->Get(sizeof(T), alignof(T)).Deallocate(p);
+        }
+        else
+        {
+            std::allocator<T>().deallocate(p, n);
+        }
+    }
+
+    const NodePools& GetPools() const
+    {
+        return *pools_;
+    }
+
+    NodePools& GetPools()
+    {
+        return *pools_;
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>& other) const
+    {
+        return pools_ == other.pools_;
+    }
+
+    template <typename U>
+    bool operator!=(const PoolAllocator<U>& other) const
+    {
+        return pools_ != other.pools_;
+    }
+
+private:
+    template <typename U>
+    friend class PoolAllocator;
+
+    std::shared_ptr<NodePools> pools_;
+};
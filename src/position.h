@@ -1,7 +1,9 @@
 #pragma once
 
-// for tasting only so far
+// position in world block coordinates
 struct Position
 {
     int x = 0;
+    int y = 0;
+    int z = 0;
 };
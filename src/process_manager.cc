@@ -1,11 +1,115 @@
 #pragma once
 
+#include <cmath>
+
 #include "process_manager.h"
 
+ProcessManager::ProcessManager()
+{
+    tick_ = 0;
+    time_ = 0;
+    has_updated_ = false;
+    frame_budget_ = std::chrono::microseconds(0);
+    deferred_count_ = 0;
+}
+
 void ProcessManager::Update()
 {
+    const auto now = std::chrono::steady_clock::now();
+    const std::chrono::duration<double> elapsed = has_updated_ ? now - last_update_ : std::chrono::duration<double>(0);
+    has_updated_ = true;
+    last_update_ = now;
+    Update(elapsed);
+}
+
+void ProcessManager::Update(std::chrono::duration<double> elapsed)
+{
+    ++tick_;
+    time_ += elapsed.count();
+    const auto start = std::chrono::steady_clock::now();
     for (auto const& process: processes_)
     {
+        ProcessState& state = states_[process.first];
+        if (!IsDue(state))
+        {
+            continue;
+        }
+        // load shedding
+        if (state.schedule.optional && !state.deferred && frame_budget_.count() > 0 && std::chrono::steady_clock::now() - start > frame_budget_)
+        {
+            state.deferred = true;
+            ++deferred_count_;
+            continue;
+        }
+        state.deferred = false;
+        state.woken = false;
+        if (state.schedule.hz > 0)
+        {
+            // skip the updates missed (e.g. after a long frame) instead of catching up
+            const double period = 1 / state.schedule.hz;
+            state.next_due_time += period;
+            if (state.next_due_time <= time_)
+            {
+                state.next_due_time = time_ + period;
+            }
+        }
         process.second->Update();
     }
 }
+
+std::uint64_t ProcessManager::GetTick() const
+{
+    return tick_;
+}
+
+void ProcessManager::SetFrameBudget(std::chrono::microseconds budget)
+{
+    frame_budget_ = budget;
+}
+
+std::uint64_t ProcessManager::GetDeferredCount() const
+{
+    return deferred_count_;
+}
+
+void ProcessManager::SetSchedule(int priority, ProcessSchedule schedule)
+{
+    assert(schedule.every_nth_tick > 0 && schedule.hz >= 0 && "Invalid schedule.");
+    // number of staggered processes with the same rate
+    std::uint64_t same_rate_count = 0;
+    for (auto const& i : states_)
+    {
+        if (i.first != priority && i.second.schedule.staggered && i.second.schedule.every_nth_tick == schedule.every_nth_tick && i.second.schedule.hz == schedule.hz)
+        {
+            ++same_rate_count;
+        }
+    }
+
+    ProcessState& state = states_[priority];
+    state.schedule = schedule;
+    state.phase = schedule.staggered ? same_rate_count % schedule.every_nth_tick : 0;
+    state.next_due_time = time_;
+    if (schedule.hz > 0 && schedule.staggered)
+    {
+        // offsets by multiples of the golden ratio spread any number of processes evenly over the period
+        const double fraction = same_rate_count * 0.6180339887;
+        state.next_due_time += (fraction - std::floor(fraction)) / schedule.hz;
+    }
+}
+
+bool ProcessManager::IsDue(const ProcessState& state) const
+{
+    if (state.asleep)
+    {
+        return false;
+    }
+    if (state.woken || state.deferred)
+    {
+        return true;
+    }
+    if (state.schedule.hz > 0)
+    {
+        return time_ >= state.next_due_time;
+    }
+    return (tick_ + state.phase) % state.schedule.every_nth_tick == 0;
+}
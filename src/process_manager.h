@@ -1,26 +1,116 @@
 #pragma once
 
+#include <cassert>
+#include <chrono>
+#include <cinttypes>
 #include <map>
 #include <memory>
 #include <string>
 #include <typeinfo>
+#include <utility>
 
+#include "event_manager.h"
 #include "process.h"
 
+// when a process is updated (see ProcessManager::SetSchedule)
+struct ProcessSchedule
+{
+    static ProcessSchedule EveryFrame()
+    {
+        return ProcessSchedule();
+    }
+
+    static ProcessSchedule EveryNthTick(std::uint64_t n)
+    {
+        ProcessSchedule schedule;
+        schedule.every_nth_tick = n;
+        return schedule;
+    }
+
+    static ProcessSchedule Hz(double hz)
+    {
+        ProcessSchedule schedule;
+        schedule.hz = hz;
+        return schedule;
+    }
+
+    // updated in every n-th call of ProcessManager::Update
+    std::uint64_t every_nth_tick = 1;
+    // if positive, updated hz times per second (of the time passed to ProcessManager::Update) instead
+    double hz = 0;
+    // processes with the same rate are updated on different ticks (or at different times within the period)
+    bool staggered = true;
+    // skipped when the frame budget is exceeded (but never twice in a row)
+    bool optional = false;
+};
+
+template <typename TEvent, typename TProcess>
+class ProcessWaker;
+
 class ProcessManager
 {
 public:
+    ProcessManager();
+
+    // measures the elapsed time itself
     void Update();
+    // for fixed time steps
+    void Update(std::chrono::duration<double> elapsed);
+    // number of calls of Update
+    std::uint64_t GetTick() const;
 
-    template <typename T>
-    void RegisterProcess(int priority)
+    // optional processes due after this much time has been spent in Update are deferred to the next frame (0: no limit)
+    void SetFrameBudget(std::chrono::microseconds budget);
+    // number of times an optional process has been deferred
+    std::uint64_t GetDeferredCount() const;
+
+    // further arguments are passed to the constructor of the process (e.g. a reference to the entity manager)
+    template <typename T, typename... Args>
+    void RegisterProcess(int priority, Args&&... args)
     {
         // assert that the process has not already been registered
         assert(processes_.find(priority) == processes_.end() && "Process already registered.");
         // priority is also the identifier of a process
         process_type_to_priority_map_.insert({typeid(T).name(), priority});
         // pointer to process
-        processes_.insert({priority, std::make_shared<T>()});
+        processes_.insert({priority, std::make_shared<T>(std::forward<Args>(args)...)});
+        // updated every frame unless SetSchedule is called
+        states_.insert({priority, ProcessState()});
+    }
+
+    template <typename T>
+    void SetSchedule(ProcessSchedule schedule)
+    {
+        SetSchedule(PriorityOf<T>(), schedule);
+    }
+
+    // sleeping processes are not updated until they are woken
+    template <typename T>
+    void Sleep()
+    {
+        states_[PriorityOf<T>()].asleep = true;
+    }
+
+    // the process is updated in the next frame (even if it is not due), then according to its schedule
+    template <typename T>
+    void Wake()
+    {
+        ProcessState& state = states_[PriorityOf<T>()];
+        state.asleep = false;
+        state.woken = true;
+    }
+
+    template <typename T>
+    bool IsAsleep()
+    {
+        return states_[PriorityOf<T>()].asleep;
+    }
+
+    // wake the process whenever the event is published
+    template <typename TEvent, typename TProcess>
+    void WakeOn(EventManager& event_manager)
+    {
+        event_manager.Subscribe<TEvent>(std::make_shared<ProcessWaker<TEvent, TProcess>>(*this));
     }
 
     template <typename T>
@@ -37,6 +127,48 @@ public:
     }
 
 private:
+    struct ProcessState
+    {
+        ProcessSchedule schedule;
+        // the process is updated when (tick + phase) is a multiple of every_nth_tick
+        std::uint64_t phase = 0;
+        // for schedules in Hz
+        double next_due_time = 0;
+        bool asleep = false;
+        bool woken = false;
+        bool deferred = false;
+    };
+
+    void SetSchedule(int priority, ProcessSchedule schedule);
+    bool IsDue(const ProcessState&) const;
+
     std::map<std::string, int> process_type_to_priority_map_;
     std::map<int, std::shared_ptr<IProcess>> processes_;
+    // indexed by priority like processes_
+    std::map<int, ProcessState> states_;
+    std::uint64_t tick_;
+    // seconds passed to Update
+    double time_;
+    bool has_updated_;
+    std::chrono::steady_clock::time_point last_update_;
+    std::chrono::microseconds frame_budget_;
+    std::uint64_t deferred_count_;
+};
+
+// subscribed to the event manager by ProcessManager::WakeOn
+template <typename TEvent, typename TProcess>
+class ProcessWaker
+{
+public:
+    explicit ProcessWaker(ProcessManager& process_manager) : process_manager_(process_manager)
+    {
+    }
+
+    void Receive(TEvent&)
+    {
+        process_manager_.Wake<TProcess>();
+    }
+
+private:
+    ProcessManager& process_manager_;
 };
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+// a singleton stored once per entity manager (world seed, camera, time, ...), see EntityManager::SetResource
+class IResource
+{
+public:
+    virtual ~IResource() = default;
+
+    // deep copy, used to fork the state of an entity manager
+    virtual std::shared_ptr<IResource> Clone() const = 0;
+};
+
+template <typename T>
+class Resource : public IResource
+{
+public:
+    explicit Resource(T value) : value_(std::move(value))
+    {
+    }
+
+    std::shared_ptr<IResource> Clone() const override
+    {
+        return std::make_shared<Resource<T>>(value_);
+    }
+
+    T value_;
+};
+
+// every resource type gets an index on first use, which is the same for all entity managers
+inline std::size_t NextResourceIndex()
+{
+    static std::atomic<std::size_t> next_index{0};
+    return next_index++;
+}
+
+template <typename T>
+std::size_t ResourceIndexOf()
+{
+    static const std::size_t index = NextResourceIndex();
+    return index;
+}
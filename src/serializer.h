@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cinttypes>
+#include <istream>
+#include <ostream>
+#include <type_traits>
+
+/*
+Serialization of components for snapshots.
+
+Trivially copyable components do not need anything: a component pool is written as one contiguous block of raw bytes.
+Components which are not trivially copyable (or which want a stable format independent of their memory layout)
+specialize Serializer, for example:
+
+template <>
+struct Serializer<Name>
+{
+    static constexpr bool kCustom = true;
+    static constexpr std::uint32_t kVersion = 1;
+    static void Write(std::ostream& os, const Name& name) { ... }
+    static bool Read(std::istream& is, Name& name) { ... }
+};
+
+kVersion is stored in the snapshot and has to match when loading. Increase it whenever the format changes.
+*/
+template <typename T>
+struct Serializer
+{
+    static constexpr bool kCustom = false;
+    static constexpr std::uint32_t kVersion = 0;
+};
+
+template <typename T>
+constexpr bool IsSerializable()
+{
+    return Serializer<T>::kCustom || std::is_trivially_copyable<T>::value;
+}
+
+// write/read a single trivially copyable value
+template <typename T>
+void WriteValue(std::ostream& os, const T& value)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "WriteValue requires a trivially copyable type.");
+    os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool ReadValue(std::istream& is, T& value)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "ReadValue requires a trivially copyable type.");
+    return static_cast<bool>(is.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+// write/read count trivially copyable values stored contiguously
+template <typename T>
+void WriteBlock(std::ostream& os, const T* data, std::uint64_t count)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "WriteBlock requires a trivially copyable type.");
+    os.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(count * sizeof(T)));
+}
+
+template <typename T>
+bool ReadBlock(std::istream& is, T* data, std::uint64_t count)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "ReadBlock requires a trivially copyable type.");
+    return static_cast<bool>(is.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(count * sizeof(T))));
+}
+
+// upper bound of the size of a block if the stream cannot tell how many bytes are left
+constexpr std::uint64_t MAX_BLOCK_SIZE = std::uint64_t(1) << 32;
+
+// read the number of elements of the block which follows, each element takes at least element_size bytes in the stream
+// fails if the elements cannot fit into the rest of the stream, so that a corrupted count is not used to size a vector
+inline bool ReadCount(std::istream& is, std::uint64_t& count, std::uint64_t element_size)
+{
+    if (!ReadValue(is, count))
+    {
+        return false;
+    }
+    std::uint64_t remaining = MAX_BLOCK_SIZE;
+    const std::istream::pos_type position = is.tellg();
+    if (position != std::istream::pos_type(-1))
+    {
+        is.seekg(0, std::ios::end);
+        const std::istream::pos_type end = is.tellg();
+        is.seekg(position);
+        if (end != std::istream::pos_type(-1) && end >= position)
+        {
+            remaining = static_cast<std::uint64_t>(end - position);
+        }
+    }
+    return static_cast<bool>(is) && count <= remaining / element_size;
+}
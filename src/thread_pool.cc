@@ -0,0 +1,80 @@
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(unsigned thread_count)
+{
+    for (unsigned i = 0; i < thread_count; ++i)
+    {
+        threads_.emplace_back(&ThreadPool::Work, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    start_cv_.notify_all();
+    for (auto& thread : threads_)
+    {
+        thread.join();
+    }
+}
+
+void ThreadPool::ParallelFor(std::size_t count, const std::function<void(std::size_t)>& body)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        body_ = &body;
+        count_ = count;
+        next_ = 0;
+        active_ = threads_.size();
+        ++generation_;
+    }
+    start_cv_.notify_all();
+    RunIterations();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this] { return active_ == 0; });
+    body_ = nullptr;
+}
+
+unsigned ThreadPool::GetThreadCount() const
+{
+    return static_cast<unsigned>(threads_.size());
+}
+
+void ThreadPool::Work()
+{
+    std::uint64_t generation = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            start_cv_.wait(lock, [this, generation] { return stop_ || generation_ != generation; });
+            if (stop_)
+            {
+                return;
+            }
+            generation = generation_;
+        }
+        RunIterations();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            --active_;
+        }
+        done_cv_.notify_one();
+    }
+}
+
+void ThreadPool::RunIterations()
+{
+    for (std::size_t i = next_++; i < count_; i = next_++)
+    {
+        (*body_)(i);
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cinttypes>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// fixed number of worker threads which execute the iterations of ParallelFor
+class ThreadPool
+{
+public:
+    // with 0 threads, ParallelFor runs everything on the calling thread
+    explicit ThreadPool(unsigned thread_count);
+    ~ThreadPool();
+
+    // calls body(i) for every i in [0, count) and returns when all calls are done (the calling thread helps)
+    void ParallelFor(std::size_t count, const std::function<void(std::size_t)>& body);
+
+    unsigned GetThreadCount() const;
+
+private:
+    void Work();
+    void RunIterations();
+
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable start_cv_;
+    std::condition_variable done_cv_;
+    const std::function<void(std::size_t)>* body_ = nullptr;
+    std::size_t count_ = 0;
+    std::atomic<std::size_t> next_{0};
+    // workers which have not finished the current job yet
+    std::size_t active_ = 0;
+    std::uint64_t generation_ = 0;
+    bool stop_ = false;
+};
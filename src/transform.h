@@ -0,0 +1,27 @@
+#pragma once
+
+#include "entity.h"
+
+// position and scale relative to the parent (or to the world if the entity has no parent)
+struct Transform
+{
+    float x = 0;
+    float y = 0;
+    float z = 0;
+    float scale = 1;
+};
+
+// computed by TransformProcess from the transforms of the entity and all its ancestors
+struct WorldTransform
+{
+    float x = 0;
+    float y = 0;
+    float z = 0;
+    float scale = 1;
+};
+
+// entities with this component are children of the given parent entity
+struct Hierarchy
+{
+    Entity parent;
+};
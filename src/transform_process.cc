@@ -0,0 +1,171 @@
+#include <algorithm>
+#include <map>
+
+#include "transform_process.h"
+
+TransformProcess::TransformProcess(EntityManager& entity_manager) : entity_manager_(entity_manager)
+{
+    auto hierarchy_changed = [this](Entity) { hierarchy_changed_ = true; };
+    auto hierarchy_batch_changed = [this](const std::vector<Entity>&) { hierarchy_changed_ = true; };
+    hierarchy_observers_.push_back(entity_manager_.Observe<Hierarchy>(ComponentEvent::kAdd, hierarchy_changed));
+    hierarchy_observers_.push_back(entity_manager_.Observe<Hierarchy>(ComponentEvent::kRemove, hierarchy_changed));
+    hierarchy_observers_.push_back(entity_manager_.ObserveBatch<Hierarchy>(ComponentEvent::kChange, hierarchy_batch_changed));
+    transform_observers_.push_back(entity_manager_.Observe<Transform>(ComponentEvent::kAdd, hierarchy_changed));
+    transform_observers_.push_back(entity_manager_.Observe<Transform>(ComponentEvent::kRemove, hierarchy_changed));
+    transform_observers_.push_back(entity_manager_.ObserveBatch<Transform>(ComponentEvent::kChange, [this](const std::vector<Entity>& entities) { MarkDirty(entities); }));
+}
+
+TransformProcess::~TransformProcess()
+{
+    for (auto id : hierarchy_observers_)
+    {
+        entity_manager_.Unobserve<Hierarchy>(id);
+    }
+    for (auto id : transform_observers_)
+    {
+        entity_manager_.Unobserve<Transform>(id);
+    }
+}
+
+void TransformProcess::Update()
+{
+    entity_manager_.FlushObservers<Hierarchy>();
+    entity_manager_.FlushObservers<Transform>();
+    if (hierarchy_changed_)
+    {
+        Rebuild();
+        hierarchy_changed_ = false;
+    }
+
+    // parents come before their children, so a dirty parent has already been recomputed (and its flag is still set)
+    updated_count_ = 0;
+    changed_.clear();
+    for (std::size_t i = 0; i < entities_.size(); ++i)
+    {
+        const std::int64_t parent = parent_indices_[i];
+        if (parent >= 0 && dirty_[parent])
+        {
+            dirty_[i] = 1;
+        }
+        if (!dirty_[i])
+        {
+            continue;
+        }
+
+        const Transform& local = local_transforms_[i];
+        WorldTransform world{local.x, local.y, local.z, local.scale};
+        if (parent >= 0)
+        {
+            const WorldTransform& parent_world = world_transforms_[parent];
+            world.x = parent_world.x + parent_world.scale * local.x;
+            world.y = parent_world.y + parent_world.scale * local.y;
+            world.z = parent_world.z + parent_world.scale * local.z;
+            world.scale = parent_world.scale * local.scale;
+        }
+        ++updated_count_;
+
+        WorldTransform& previous = world_transforms_[i];
+        if (written_[i] && previous.x == world.x && previous.y == world.y && previous.z == world.z && previous.scale == world.scale)
+        {
+            continue;
+        }
+        previous = world;
+        changed_.push_back(i);
+    }
+    std::fill(dirty_.begin(), dirty_.end(), 0);
+
+    // only the changed world transforms are written to the components
+    auto world_transforms = entity_manager_.GetComponentMap<WorldTransform>();
+    for (auto i : changed_)
+    {
+        if (!written_[i] && world_transforms->entity_component_map_.count(entities_[i]) == 0)
+        {
+            entity_manager_.AddComponent(entities_[i], world_transforms_[i]);
+        }
+        else
+        {
+            entity_manager_.GetComponent<WorldTransform>(entities_[i]) = world_transforms_[i];
+        }
+        written_[i] = 1;
+    }
+}
+
+std::uint64_t TransformProcess::GetUpdatedCount() const
+{
+    return updated_count_;
+}
+
+void TransformProcess::Rebuild()
+{
+    auto transforms = entity_manager_.GetComponentMap<Transform>();
+    auto hierarchies = entity_manager_.GetComponentMap<Hierarchy>();
+
+    // children of every entity which has a Transform, roots are entities without (transformed) parent
+    std::map<Entity, std::vector<Entity>> children;
+    std::vector<Entity> roots;
+    for (auto const& i : transforms->entity_component_map_)
+    {
+        auto it = hierarchies->entity_component_map_.find(i.first);
+        if (it != hierarchies->entity_component_map_.end() && transforms->entity_component_map_.count(it->second.parent) > 0)
+        {
+            children[it->second.parent].push_back(i.first);
+        }
+        else
+        {
+            roots.push_back(i.first);
+        }
+    }
+
+    entities_.clear();
+    parent_indices_.clear();
+    index_of_.clear();
+    // depth-first traversal (entities in cycles are not reachable from a root and thus ignored)
+    std::vector<std::pair<Entity, std::int64_t>> stack;
+    for (auto it = roots.rbegin(); it != roots.rend(); ++it)
+    {
+        stack.push_back({*it, -1});
+    }
+    while (!stack.empty())
+    {
+        auto [entity, parent] = stack.back();
+        stack.pop_back();
+        const std::int64_t index = entities_.size();
+        entities_.push_back(entity);
+        parent_indices_.push_back(parent);
+        index_of_[entity.id_] = index;
+
+        auto it = children.find(entity);
+        if (it != children.end())
+        {
+            for (auto child = it->second.rbegin(); child != it->second.rend(); ++child)
+            {
+                stack.push_back({*child, index});
+            }
+        }
+    }
+
+    local_transforms_.clear();
+    local_transforms_.reserve(entities_.size());
+    for (auto entity : entities_)
+    {
+        local_transforms_.push_back(transforms->entity_component_map_.at(entity));
+    }
+    world_transforms_.assign(entities_.size(), WorldTransform());
+    written_.assign(entities_.size(), 0);
+    dirty_.assign(entities_.size(), 1);
+}
+
+void TransformProcess::MarkDirty(const std::vector<Entity>& entities)
+{
+    // the changes are delivered after the components have been modified, so the copies are up to date
+    auto transforms = entity_manager_.GetComponentMap<Transform>();
+    for (auto entity : entities)
+    {
+        auto it = index_of_.find(entity.id_);
+        if (it != index_of_.end())
+        {
+            dirty_[it->second] = 1;
+            local_transforms_[it->second] = transforms->entity_component_map_.at(entity);
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cinttypes>
+#include <unordered_map>
+#include <vector>
+
+#include "entity.h"
+#include "entity_manager.h"
+#include "process.h"
+#include "transform.h"
+#include "type.h"
+
+/*
+Computes the WorldTransform of every entity with a Transform component.
+
+The hierarchy (given by Hierarchy components) is flattened into arrays in depth-first order, i.e., every parent comes
+before its children. The local transforms are copied into these arrays when they change, so the world transforms are
+computed in one linear sweep over the arrays without looking up any component.
+Only entities whose Transform changed (or one of their ancestors' Transform) are recomputed, static subtrees are skipped,
+and only world transforms which actually changed are written back to the WorldTransform components.
+Changes are detected by observing Transform and Hierarchy components, the arrays are rebuilt only if the hierarchy changes.
+
+The process flushes the observers of Transform and Hierarchy (EntityManager::FlushObservers<T>) at the beginning of each
+update, the notifications of other component types are left to the owner of the frame loop.
+The component types Transform, WorldTransform, and Hierarchy have to be registered before the process is created.
+*/
+class TransformProcess : public IProcess
+{
+public:
+    explicit TransformProcess(EntityManager& entity_manager);
+    ~TransformProcess();
+
+    void Update();
+
+    // number of world transforms computed in the last update
+    std::uint64_t GetUpdatedCount() const;
+
+private:
+    void Rebuild();
+    void MarkDirty(const std::vector<Entity>& entities);
+
+    EntityManager& entity_manager_;
+    std::vector<ObserverIdType> hierarchy_observers_;
+    std::vector<ObserverIdType> transform_observers_;
+    bool hierarchy_changed_ = true;
+    std::uint64_t updated_count_ = 0;
+
+    // in depth-first order
+    std::vector<Entity> entities_;
+    // index of the parent in the arrays, -1 for roots
+    std::vector<std::int64_t> parent_indices_;
+    // copies of the Transform components
+    std::vector<Transform> local_transforms_;
+    std::vector<WorldTransform> world_transforms_;
+    std::vector<char> dirty_;
+    // whether the world transform has been written to the WorldTransform component since the last rebuild
+    std::vector<char> written_;
+    // indices of the world transforms changed in the current update
+    std::vector<std::size_t> changed_;
+    std::unordered_map<EntityIdType, std::size_t> index_of_;
+};
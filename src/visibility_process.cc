@@ -0,0 +1,141 @@
+#include <cmath>
+#include <queue>
+
+#include "visibility_process.h"
+
+namespace {
+    const int FACE_DIRECTIONS[6][3] = {{-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}};
+
+    struct Step
+    {
+        ChunkCoord coord;
+        // face through which the chunk was entered, -1 for the camera chunk
+        int entry_face;
+        // faces (directions) used on the way from the camera
+        int directions;
+    };
+}
+
+VisibilityProcess::VisibilityProcess(VoxelWorld& world, int view_distance) : world_(world), view_distance_(view_distance)
+{
+    world_observer_ = world_.Observe([this](int x, int y, int z, bool) { connectivity_.erase(ChunkCoordOf(x, y, z)); });
+}
+
+VisibilityProcess::~VisibilityProcess()
+{
+    world_.Unobserve(world_observer_);
+}
+
+void VisibilityProcess::SetCamera(const Vec3& eye, const Frustum& frustum)
+{
+    eye_ = eye;
+    frustum_ = frustum;
+}
+
+void VisibilityProcess::Update()
+{
+    const ChunkCoord camera = ChunkCoordOf(static_cast<int>(std::floor(eye_.x)), static_cast<int>(std::floor(eye_.y)), static_cast<int>(std::floor(eye_.z)));
+    const int side = 2 * view_distance_ + 1;
+    auto index_of = [this, side](int dx, int dy, int dz) {
+        return ((dx + view_distance_) * side + (dy + view_distance_)) * side + (dz + view_distance_);
+    };
+
+    /* frustum test of all chunks in the cube around the camera */
+
+    boxes_.Resize(side * side * side);
+    for (int dx = -view_distance_; dx <= view_distance_; ++dx)
+    {
+        for (int dy = -view_distance_; dy <= view_distance_; ++dy)
+        {
+            for (int dz = -view_distance_; dz <= view_distance_; ++dz)
+            {
+                const int i = index_of(dx, dy, dz);
+                boxes_.min_x[i] = static_cast<float>((camera.x + dx) * CHUNK_SIZE);
+                boxes_.min_y[i] = static_cast<float>((camera.y + dy) * CHUNK_SIZE);
+                boxes_.min_z[i] = static_cast<float>((camera.z + dz) * CHUNK_SIZE);
+                boxes_.max_x[i] = boxes_.min_x[i] + CHUNK_SIZE;
+                boxes_.max_y[i] = boxes_.min_y[i] + CHUNK_SIZE;
+                boxes_.max_z[i] = boxes_.min_z[i] + CHUNK_SIZE;
+            }
+        }
+    }
+    frustum_.CullAabbs(boxes_, in_frustum_);
+    in_frustum_count_ = 0;
+    for (auto v : in_frustum_)
+    {
+        in_frustum_count_ += v;
+    }
+
+    /* breadth-first search through the connectivity graph */
+
+    visible_chunks_.clear();
+    std::vector<char> visited(in_frustum_.size(), 0);
+    std::queue<Step> queue;
+    queue.push(Step{camera, -1, 0});
+    visited[index_of(0, 0, 0)] = 1;
+    while (!queue.empty())
+    {
+        const Step step = queue.front();
+        queue.pop();
+        if (world_.GetChunk(step.coord))
+        {
+            visible_chunks_.push_back(step.coord);
+        }
+        const ChunkConnectivity& connectivity = ConnectivityOf(step.coord);
+
+        for (int face = 0; face < 6; ++face)
+        {
+            // never step back towards the camera
+            if (step.directions & (1 << (face ^ 1)))
+            {
+                continue;
+            }
+            if (step.entry_face >= 0 && !connectivity.IsConnected(step.entry_face, face))
+            {
+                continue;
+            }
+            const ChunkCoord next{step.coord.x + FACE_DIRECTIONS[face][0], step.coord.y + FACE_DIRECTIONS[face][1], step.coord.z + FACE_DIRECTIONS[face][2]};
+            const int dx = next.x - camera.x;
+            const int dy = next.y - camera.y;
+            const int dz = next.z - camera.z;
+            if (std::abs(dx) > view_distance_ || std::abs(dy) > view_distance_ || std::abs(dz) > view_distance_)
+            {
+                continue;
+            }
+            const int i = index_of(dx, dy, dz);
+            if (visited[i] || !in_frustum_[i])
+            {
+                continue;
+            }
+            visited[i] = 1;
+            queue.push(Step{next, face ^ 1, step.directions | (1 << face)});
+        }
+    }
+}
+
+const std::vector<ChunkCoord>& VisibilityProcess::GetVisibleChunks() const
+{
+    return visible_chunks_;
+}
+
+std::uint64_t VisibilityProcess::GetInFrustumCount() const
+{
+    return in_frustum_count_;
+}
+
+const ChunkConnectivity& VisibilityProcess::ConnectivityOf(ChunkCoord coord)
+{
+    auto it = connectivity_.find(coord);
+    if (it != connectivity_.end())
+    {
+        return it->second;
+    }
+    auto chunk = world_.GetChunk(coord);
+    if (!chunk)
+    {
+        // unloaded chunks are air (and not cached)
+        static const ChunkConnectivity all_connected = ChunkConnectivity::AllConnected();
+        return all_connected;
+    }
+    return connectivity_[coord] = ChunkConnectivity::Compute(*chunk);
+}
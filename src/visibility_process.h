@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cinttypes>
+#include <map>
+#include <vector>
+
+#include "chunk.h"
+#include "chunk_connectivity.h"
+#include "frustum.h"
+#include "process.h"
+#include "type.h"
+#include "voxel_world.h"
+
+/*
+Determines the loaded chunks which are potentially visible from the camera.
+
+First, the boxes of all chunks within the view distance are tested against the view frustum (in one batch, see
+Frustum::CullAabbs). Then, a breadth-first search starts at the camera chunk and only continues from a chunk into its
+neighbor if the neighbor is in the frustum, the chunk connects the face through which it was entered with the face
+towards the neighbor (see ChunkConnectivity), and the step does not go back towards the camera.
+Chunks behind solid terrain (e.g. caves below the ground) are thus not reached.
+
+The connectivity of a chunk is computed when it is first needed and recomputed after its blocks changed.
+*/
+class VisibilityProcess : public IProcess
+{
+public:
+    // view distance in chunks
+    VisibilityProcess(VoxelWorld& world, int view_distance);
+    ~VisibilityProcess();
+
+    void SetCamera(const Vec3& eye, const Frustum& frustum);
+    void Update();
+
+    const std::vector<ChunkCoord>& GetVisibleChunks() const;
+    // number of chunks within the view distance which are in the frustum (before occlusion culling)
+    std::uint64_t GetInFrustumCount() const;
+
+private:
+    const ChunkConnectivity& ConnectivityOf(ChunkCoord coord);
+
+    VoxelWorld& world_;
+    ObserverIdType world_observer_;
+    int view_distance_;
+    Vec3 eye_;
+    Frustum frustum_;
+    std::vector<ChunkCoord> visible_chunks_;
+    std::uint64_t in_frustum_count_ = 0;
+    // cube of chunks around the camera chunk
+    AabbArrays boxes_;
+    std::vector<char> in_frustum_;
+    std::map<ChunkCoord, ChunkConnectivity> connectivity_;
+};
@@ -0,0 +1,75 @@
+#include "voxel_world.h"
+
+VoxelWorld::VoxelWorld()
+{
+    next_observer_id_ = 0;
+}
+
+BlockType VoxelWorld::GetBlock(int x, int y, int z) const
+{
+    auto it = chunks_.find(ChunkCoordOf(x, y, z));
+    if (it == chunks_.end())
+    {
+        return AIR;
+    }
+    return it->second->GetBlock(FloorMod(x, CHUNK_SIZE), FloorMod(y, CHUNK_SIZE), FloorMod(z, CHUNK_SIZE));
+}
+
+void VoxelWorld::SetBlock(int x, int y, int z, BlockType block)
+{
+    auto& chunk = chunks_[ChunkCoordOf(x, y, z)];
+    if (!chunk)
+    {
+        chunk = std::make_shared<Chunk>();
+    }
+    chunk->SetBlock(FloorMod(x, CHUNK_SIZE), FloorMod(y, CHUNK_SIZE), FloorMod(z, CHUNK_SIZE), block);
+    Notify(x, y, z, false);
+}
+
+std::shared_ptr<const Chunk> VoxelWorld::GetChunk(ChunkCoord coord) const
+{
+    auto it = chunks_.find(coord);
+    if (it == chunks_.end())
+    {
+        return nullptr;
+    }
+    return it->second;
+}
+
+void VoxelWorld::SetChunk(ChunkCoord coord, std::shared_ptr<Chunk> chunk)
+{
+    chunks_[coord] = chunk;
+    Notify(coord.x * CHUNK_SIZE, coord.y * CHUNK_SIZE, coord.z * CHUNK_SIZE, true);
+}
+
+void VoxelWorld::RemoveChunk(ChunkCoord coord)
+{
+    if (chunks_.erase(coord) > 0)
+    {
+        Notify(coord.x * CHUNK_SIZE, coord.y * CHUNK_SIZE, coord.z * CHUNK_SIZE, true);
+    }
+}
+
+const std::map<ChunkCoord, std::shared_ptr<Chunk>>& VoxelWorld::GetChunks() const
+{
+    return chunks_;
+}
+
+ObserverIdType VoxelWorld::Observe(std::function<void(int x, int y, int z, bool whole_chunk)> callback)
+{
+    observers_.insert({next_observer_id_, callback});
+    return next_observer_id_++;
+}
+
+void VoxelWorld::Unobserve(ObserverIdType observer_id)
+{
+    observers_.erase(observer_id);
+}
+
+void VoxelWorld::Notify(int x, int y, int z, bool whole_chunk)
+{
+    for (auto const& cb : observers_)
+    {
+        cb.second(x, y, z, whole_chunk);
+    }
+}
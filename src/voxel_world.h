@@ -0,0 +1,38 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+
+#include "chunk.h"
+#include "type.h"
+
+// all loaded chunks, addressed with world block coordinates
+class VoxelWorld
+{
+public:
+    VoxelWorld();
+
+    // blocks in chunks which are not loaded are air
+    BlockType GetBlock(int x, int y, int z) const;
+    // creates the chunk if it is not loaded
+    void SetBlock(int x, int y, int z, BlockType block);
+
+    // nullptr if the chunk is not loaded
+    std::shared_ptr<const Chunk> GetChunk(ChunkCoord coord) const;
+    void SetChunk(ChunkCoord coord, std::shared_ptr<Chunk> chunk);
+    void RemoveChunk(ChunkCoord coord);
+    const std::map<ChunkCoord, std::shared_ptr<Chunk>>& GetChunks() const;
+
+    // observers are called with the world coordinates of every changed block
+    // (for SetChunk/RemoveChunk with the coordinates of the first block of the chunk and whole_chunk = true)
+    ObserverIdType Observe(std::function<void(int x, int y, int z, bool whole_chunk)> callback);
+    void Unobserve(ObserverIdType);
+
+private:
+    void Notify(int x, int y, int z, bool whole_chunk);
+
+    ObserverIdType next_observer_id_;
+    std::map<ChunkCoord, std::shared_ptr<Chunk>> chunks_;
+    std::map<ObserverIdType, std::function<void(int, int, int, bool)>> observers_;
+};
@@ -0,0 +1,259 @@
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+#include <vector>
+
+#include "block_update_process.h"
+#include "chunk.h"
+#include "process_manager.h"
+#include "voxel_world.h"
+
+namespace test_block_update_process_namespace {
+    const BlockType STONE = 1;
+    const BlockType SAND = 2;
+    const BlockType SAPLING = 3;
+    const BlockType TREE = 4;
+    const BlockType WATER = 5;
+
+    // sand falls one block per tick into air of loaded chunks
+    void FallingSand(const VoxelWorld& world, const BlockCoord& block, BlockUpdateOutput& output)
+    {
+        if (block.y > 0 && world.GetBlock(block.x, block.y - 1, block.z) == AIR)
+        {
+            output.SetBlock(block, AIR);
+            output.SetBlock(BlockCoord{block.x, block.y - 1, block.z}, SAND);
+        }
+    }
+
+    // water flows in +x direction into air of loaded chunks
+    void FlowingWater(const VoxelWorld& world, const BlockCoord& block, BlockUpdateOutput& output)
+    {
+        if (world.GetChunk(ChunkCoordOf(block.x + 1, block.y, block.z)) && world.GetBlock(block.x + 1, block.y, block.z) == AIR)
+        {
+            output.SetBlock(block, AIR);
+            output.SetBlock(BlockCoord{block.x + 1, block.y, block.z}, WATER);
+        }
+    }
+
+    void GrowingSapling(const VoxelWorld&, const BlockCoord& block, BlockUpdateOutput& output)
+    {
+        output.SetBlock(block, TREE);
+    }
+
+    int CountBlocks(const VoxelWorld& world, BlockType type)
+    {
+        int count = 0;
+        for (auto const& i : world.GetChunks())
+        {
+            for (auto b : i.second->GetBlocks())
+            {
+                count += b == type ? 1 : 0;
+            }
+        }
+        return count;
+    }
+}
+
+BOOST_AUTO_TEST_CASE( update_active_blocks )
+{
+    using namespace test_block_update_process_namespace;
+
+    // 2 x 1 x 1 chunks with a stone floor at y = 0
+    VoxelWorld world;
+    for (int cx = 0; cx < 2; ++cx)
+    {
+        world.SetChunk(ChunkCoord{cx, 0, 0}, std::make_shared<Chunk>());
+    }
+    for (int x = 0; x < 2 * CHUNK_SIZE; ++x)
+    {
+        for (int z = 0; z < CHUNK_SIZE; ++z)
+        {
+            world.SetBlock(x, 0, z, STONE);
+        }
+    }
+
+    ProcessManager process_manager;
+    process_manager.RegisterProcess<BlockUpdateProcess>(0, world, 2);
+    auto blocks = process_manager.GetProcess<BlockUpdateProcess>();
+    blocks->RegisterRule(SAND, FallingSand);
+
+    /* nothing to do in a world without sand */
+
+    process_manager.Update();
+    BOOST_CHECK_EQUAL(blocks->GetActiveCount(), 0);
+    BOOST_CHECK_EQUAL(blocks->GetScheduledCount(), 0);
+
+    /* a column of two sand blocks in each chunk */
+
+    world.SetBlock(5, 10, 5, SAND);
+    world.SetBlock(5, 11, 5, SAND);
+    world.SetBlock(20, 4, 7, SAND);
+    world.SetBlock(20, 5, 7, SAND);
+    BOOST_CHECK_EQUAL(blocks->GetScheduledCount(), 4);
+    process_manager.Update();
+    // the lower blocks fall, the upper ones wait for them
+    BOOST_CHECK_EQUAL(blocks->GetActiveCount(), 4);
+    BOOST_CHECK_EQUAL(world.GetBlock(5, 9, 5), SAND);
+    BOOST_CHECK_EQUAL(world.GetBlock(5, 10, 5), AIR);
+    BOOST_CHECK_EQUAL(world.GetBlock(5, 11, 5), SAND);
+    BOOST_CHECK_EQUAL(world.GetBlock(20, 3, 7), SAND);
+
+    for (int i = 0; i < 20; ++i)
+    {
+        process_manager.Update();
+    }
+    BOOST_CHECK_EQUAL(world.GetBlock(5, 1, 5), SAND);
+    BOOST_CHECK_EQUAL(world.GetBlock(5, 2, 5), SAND);
+    BOOST_CHECK_EQUAL(world.GetBlock(20, 1, 7), SAND);
+    BOOST_CHECK_EQUAL(world.GetBlock(20, 2, 7), SAND);
+    BOOST_CHECK_EQUAL(CountBlocks(world, SAND), 4);
+    // the settled sand is not updated anymore
+    BOOST_CHECK_EQUAL(blocks->GetActiveCount(), 0);
+    BOOST_CHECK_EQUAL(blocks->GetScheduledCount(), 0);
+
+    /* removing the floor below activates the sand again */
+
+    world.SetBlock(5, 0, 5, AIR);
+    process_manager.Update();
+    BOOST_CHECK_EQUAL(blocks->GetActiveCount(), 1);
+    BOOST_CHECK_EQUAL(world.GetBlock(5, 0, 5), SAND);
+    process_manager.Update();
+    process_manager.Update();
+    BOOST_CHECK_EQUAL(world.GetBlock(5, 1, 5), SAND);
+    BOOST_CHECK_EQUAL(blocks->GetScheduledCount(), 0);
+
+    /* scheduling with a delay */
+
+    world.SetBlock(20, 0, 7, AIR);
+    blocks->Schedule(BlockCoord{20, 1, 7}, 3);     // already scheduled for the next tick
+    blocks->Schedule(BlockCoord{20, 1, 7}, 3);
+    BOOST_CHECK_EQUAL(blocks->GetScheduledCount(), 1);
+    process_manager.Update();
+    BOOST_CHECK_EQUAL(world.GetBlock(20, 0, 7), SAND);
+    process_manager.Update();
+    process_manager.Update();
+    BOOST_CHECK_EQUAL(blocks->GetScheduledCount(), 0);
+
+    /* loading a chunk activates its blocks */
+
+    auto chunk = std::make_shared<Chunk>();
+    chunk->SetBlock(3, 3, 3, SAND);
+    world.SetChunk(ChunkCoord{0, 1, 0}, chunk);
+    BOOST_CHECK_EQUAL(blocks->GetScheduledCount(), 1);
+    for (int i = 0; i < CHUNK_SIZE + 3; ++i)
+    {
+        process_manager.Update();
+    }
+    BOOST_CHECK_EQUAL(world.GetBlock(3, CHUNK_SIZE + 3, 3), AIR);
+    BOOST_CHECK_EQUAL(world.GetBlock(3, 1, 3), SAND);     // fell through the chunk border onto the floor
+    BOOST_CHECK_EQUAL(blocks->GetScheduledCount(), 0);
+}
+
+BOOST_AUTO_TEST_CASE( reject_conflicting_changes )
+{
+    using namespace test_block_update_process_namespace;
+
+    VoxelWorld world;
+    world.SetChunk(ChunkCoord{0, 0, 0}, std::make_shared<Chunk>());
+    BlockUpdateProcess blocks(world, 2);
+    blocks.RegisterRule(SAND, FallingSand);
+    blocks.RegisterRule(WATER, FlowingWater);
+
+    // the sand falls into the block the water flows into
+    world.SetBlock(5, 2, 5, SAND);
+    world.SetBlock(4, 1, 5, WATER);
+    for (int x = 0; x < CHUNK_SIZE; ++x)
+    {
+        world.SetBlock(x, 0, 5, STONE);
+    }
+    blocks.Update();
+    BOOST_CHECK_EQUAL(blocks.GetConflictCount(), 1);
+    BOOST_CHECK_EQUAL(CountBlocks(world, SAND), 1);
+    BOOST_CHECK_EQUAL(CountBlocks(world, WATER), 1);
+
+    // the rejected block is updated again and nothing is lost
+    for (int i = 0; i < 2 * CHUNK_SIZE; ++i)
+    {
+        blocks.Update();
+    }
+    BOOST_CHECK_EQUAL(CountBlocks(world, SAND), 1);
+    BOOST_CHECK_EQUAL(CountBlocks(world, WATER), 1);
+    BOOST_CHECK_EQUAL(world.GetBlock(5, 1, 5), SAND);
+    BOOST_CHECK_EQUAL(world.GetBlock(CHUNK_SIZE - 1, 1, 5), WATER);
+}
+
+BOOST_AUTO_TEST_CASE( update_random_blocks )
+{
+    using namespace test_block_update_process_namespace;
+
+    VoxelWorld world;
+    world.SetChunk(ChunkCoord{0, 0, 0}, std::make_shared<Chunk>());
+    for (int x = 0; x < CHUNK_SIZE; ++x)
+    {
+        for (int z = 0; z < CHUNK_SIZE; ++z)
+        {
+            world.SetBlock(x, 0, z, SAPLING);
+        }
+    }
+
+    BlockUpdateProcess blocks(world, 1, 64);
+    blocks.RegisterRandomTickRule(SAPLING, GrowingSapling);
+    // random tick rules are not scheduled
+    BOOST_CHECK_EQUAL(blocks.GetScheduledCount(), 0);
+
+    // 64 random blocks per tick, a sixteenth of them are saplings
+    for (int i = 0; i < 10; ++i)
+    {
+        blocks.Update();
+    }
+    const int trees = CountBlocks(world, TREE);
+    BOOST_CHECK(trees > 10);
+    BOOST_CHECK(trees < 100);
+    BOOST_CHECK_EQUAL(trees + CountBlocks(world, SAPLING), CHUNK_SIZE * CHUNK_SIZE);
+}
+
+BOOST_AUTO_TEST_CASE( retry_rejected_random_tick_rules )
+{
+    using namespace test_block_update_process_namespace;
+
+    // a chunk of saplings, every sapling rule also writes the block target
+    VoxelWorld world;
+    auto chunk = std::make_shared<Chunk>();
+    for (int x = 0; x < CHUNK_SIZE; ++x)
+    {
+        for (int y = 0; y < CHUNK_SIZE; ++y)
+        {
+            for (int z = 0; z < CHUNK_SIZE; ++z)
+            {
+                chunk->SetBlock(x, y, z, SAPLING);
+            }
+        }
+    }
+    world.SetChunk(ChunkCoord{0, 0, 0}, chunk);
+    const BlockCoord target{0, CHUNK_SIZE - 1, 0};
+    const BlockCoord water{CHUNK_SIZE - 1, CHUNK_SIZE - 1, CHUNK_SIZE - 1};
+    world.SetBlock(water.x, water.y, water.z, WATER);
+
+    BlockUpdateProcess blocks(world, 1, 1);
+    std::vector<BlockCoord> calls;
+    blocks.RegisterRandomTickRule(SAPLING, [&calls, target](const VoxelWorld&, const BlockCoord& block, BlockUpdateOutput& output) {
+        calls.push_back(block);
+        output.SetBlock(block, TREE);
+        output.SetBlock(target, TREE);
+    });
+    // the scheduled rule writes the target first
+    blocks.RegisterRule(WATER, [target](const VoxelWorld&, const BlockCoord&, BlockUpdateOutput& output) { output.SetBlock(target, STONE); });
+    blocks.Schedule(water, 1);
+
+    blocks.Update();
+    BOOST_CHECK_EQUAL(blocks.GetConflictCount(), 1);
+    BOOST_REQUIRE_EQUAL(calls.size(), 1);
+    const BlockCoord rejected = calls[0];
+    BOOST_CHECK_EQUAL(world.GetBlock(rejected.x, rejected.y, rejected.z), SAPLING);
+    BOOST_CHECK_EQUAL(world.GetBlock(target.x, target.y, target.z), STONE);
+
+    // the rejected sapling grows in the next tick (the new random one conflicts with it)
+    blocks.Update();
+    BOOST_CHECK_EQUAL(world.GetBlock(rejected.x, rejected.y, rejected.z), TREE);
+    BOOST_CHECK_EQUAL(world.GetBlock(target.x, target.y, target.z), TREE);
+}
@@ -2,9 +2,16 @@
 
 #include <bitset>
 #include <iostream>
+#include <sstream>
+#include <memory>
+#include <string>
+#include <vector>
 
 #include "entity.h"
 #include "entity_manager.h"
+#include "event_manager.h"
+#include "process.h"
+#include "serializer.h"
 #include "type.h"
 
 namespace test_entity_manager_namespace{
@@ -20,8 +27,68 @@ namespace test_entity_manager_namespace{
     {
         bool c = false;
     };
+    // not trivially copyable, needs a custom serializer
+    struct TestComponent3
+    {
+        std::string d;
+    };
+    // tag
+    struct TestTag
+    {
+    };
+    // resource
+    struct TestSeed
+    {
+        int seed = 0;
+    };
+
+    // receives the events forwarded by the entity manager
+    class TestObserverProcess : public IProcess
+    {
+    public:
+        void Update()
+        {
+        }
+
+        void Receive(ComponentAdded<TestComponent0>& e)
+        {
+            added.push_back(e.entity.id_);
+        }
+
+        void Receive(ComponentChanged<TestComponent0>& e)
+        {
+            changed.push_back(e.entity.id_);
+        }
+
+        std::vector<EntityIdType> added;
+        std::vector<EntityIdType> changed;
+    };
 }
 
+template <>
+struct Serializer<test_entity_manager_namespace::TestComponent3>
+{
+    static constexpr bool kCustom = true;
+    static constexpr std::uint32_t kVersion = 1;
+
+    static void Write(std::ostream& os, const test_entity_manager_namespace::TestComponent3& component)
+    {
+        WriteValue(os, static_cast<std::uint64_t>(component.d.size()));
+        os.write(component.d.data(), component.d.size());
+    }
+
+    static bool Read(std::istream& is, test_entity_manager_namespace::TestComponent3& component)
+    {
+        std::uint64_t size;
+        if (!ReadValue(is, size))
+        {
+            return false;
+        }
+        component.d.resize(size);
+        return static_cast<bool>(is.read(&component.d[0], size));
+    }
+};
+
 BOOST_AUTO_TEST_CASE( create_and_destroy_entities )
 {
     using namespace test_entity_manager_namespace;
@@ -215,3 +282,488 @@ BOOST_AUTO_TEST_CASE( get_components_and_entity_component_map )
     entity_manager.RemoveComponent<TestComponent2>(ent2comp);
     BOOST_CHECK_EQUAL(cm_tc2->entity_component_map_.size(), 0);
 }
+
+BOOST_AUTO_TEST_CASE( destroy_entity_removes_components )
+{
+    using namespace test_entity_manager_namespace;
+
+    EntityManager entity_manager;
+    entity_manager.RegisterComponent<TestComponent0>();
+    entity_manager.RegisterComponent<TestComponent1>();
+
+    Entity ent0 = entity_manager.CreateEntity();
+    Entity ent1 = entity_manager.CreateEntity();
+    entity_manager.AddComponent(ent0, TestComponent0{1});
+    entity_manager.AddComponent(ent0, TestComponent1{2});
+    entity_manager.AddComponent(ent1, TestComponent0{3});
+
+    entity_manager.DestroyEntity(ent0);
+    BOOST_CHECK_EQUAL(entity_manager.GetComponentMap<TestComponent0>()->entity_component_map_.size(), 1);
+    BOOST_CHECK_EQUAL(entity_manager.GetComponentMap<TestComponent1>()->entity_component_map_.size(), 0);
+
+    // the destroyed entity is reused exactly once
+    Entity ent2 = entity_manager.CreateEntity();
+    Entity ent3 = entity_manager.CreateEntity();
+    BOOST_CHECK_EQUAL(ent2.id_, ent0.id_);
+    BOOST_CHECK_EQUAL(ent3.id_, 2);
+    BOOST_CHECK_EQUAL(entity_manager.GetBitField(ent2), ComponentBitField());
+}
+
+BOOST_AUTO_TEST_CASE( save_and_load_snapshot )
+{
+    using namespace test_entity_manager_namespace;
+
+    EntityManager entity_manager;
+    entity_manager.RegisterComponent<TestComponent0>();
+    entity_manager.RegisterComponent<TestComponent1>();
+    entity_manager.RegisterComponent<TestComponent3>();
+
+    Entity ent0 = entity_manager.CreateEntity();
+    Entity ent1 = entity_manager.CreateEntity();
+    Entity ent2 = entity_manager.CreateEntity();
+    entity_manager.AddComponent(ent0, TestComponent0{10});
+    entity_manager.AddComponent(ent0, TestComponent3{"zero"});
+    entity_manager.AddComponent(ent1, TestComponent1{1.5});
+    entity_manager.AddComponent(ent2, TestComponent0{12});
+    entity_manager.DestroyEntity(ent1);
+
+    std::stringstream snapshot;
+    BOOST_CHECK(entity_manager.Save(snapshot));
+
+    /* load into a fresh entity manager with the same component types */
+
+    EntityManager loaded;
+    loaded.RegisterComponent<TestComponent0>();
+    loaded.RegisterComponent<TestComponent1>();
+    loaded.RegisterComponent<TestComponent3>();
+    auto cm_tc0 = loaded.GetComponentMap<TestComponent0>();
+    Entity replaced = loaded.CreateEntity();
+    loaded.AddComponent(replaced, TestComponent1{2.5});
+    std::vector<EntityIdType> added;
+    std::vector<EntityIdType> removed;
+    loaded.Observe<TestComponent0>(ComponentEvent::kAdd, [&](Entity e) { added.push_back(e.id_); });
+    loaded.Observe<TestComponent1>(ComponentEvent::kRemove, [&](Entity e) {
+        removed.push_back(e.id_);
+        // the replaced component still exists while removal observers are called
+        BOOST_CHECK_EQUAL(loaded.PeekComponent<TestComponent1>(e).b, 2.5);
+    });
+    BOOST_CHECK(loaded.Load(snapshot));
+    // observers are notified about the replaced and the loaded components
+    BOOST_CHECK_EQUAL(removed.size(), 1);
+    BOOST_CHECK_EQUAL(removed[0], replaced.id_);
+    BOOST_CHECK_EQUAL(added.size(), 2);
+
+    BOOST_CHECK_EQUAL(loaded.GetExistingEntitiesCount(), 2);
+    BOOST_CHECK_EQUAL(loaded.GetBitField(ent0), entity_manager.GetBitField(ent0));
+    BOOST_CHECK_EQUAL(loaded.GetBitField(ent1), ComponentBitField());
+    BOOST_CHECK_EQUAL(loaded.GetBitField(ent2), entity_manager.GetBitField(ent2));
+    BOOST_CHECK_EQUAL(loaded.GetComponent<TestComponent0>(ent0).a, 10);
+    BOOST_CHECK_EQUAL(loaded.GetComponent<TestComponent0>(ent2).a, 12);
+    BOOST_CHECK_EQUAL(loaded.GetComponent<TestComponent3>(ent0).d, "zero");
+    BOOST_CHECK_EQUAL(loaded.GetComponentMap<TestComponent1>()->entity_component_map_.size(), 0);
+    // previously obtained component maps see the loaded components
+    BOOST_CHECK_EQUAL(cm_tc0->entity_component_map_.size(), 2);
+
+    // the destroyed entity is reused first, afterwards new IDs continue where the saved state stopped
+    BOOST_CHECK_EQUAL(loaded.CreateEntity().id_, ent1.id_);
+    BOOST_CHECK_EQUAL(loaded.CreateEntity().id_, 3);
+
+    /* loading fails if the component types do not match */
+
+    EntityManager mismatch;
+    mismatch.RegisterComponent<TestComponent1>();
+    mismatch.RegisterComponent<TestComponent0>();
+    mismatch.RegisterComponent<TestComponent3>();
+    snapshot.clear();
+    snapshot.seekg(0);
+    BOOST_CHECK(!mismatch.Load(snapshot));
+
+    // a truncated snapshot fails as well and leaves the entity manager unchanged
+    std::string data = snapshot.str();
+    std::stringstream truncated(data.substr(0, data.size() - 3));
+    BOOST_CHECK(!loaded.Load(truncated));
+    BOOST_CHECK_EQUAL(loaded.GetComponent<TestComponent0>(ent2).a, 12);
+
+    /* corrupted counts fail instead of allocating */
+
+    // the number of available entities follows magic, format version, next entity ID and number of existing entities
+    const std::size_t available_count_offset = 4 + 4 + 8 + 8;
+    // the number of entities follows the single available entity ID
+    const std::size_t entity_count_offset = available_count_offset + 8 + 8;
+    for (std::size_t offset : {available_count_offset, entity_count_offset})
+    {
+        std::string corrupted_data = data;
+        const std::uint64_t huge_count = std::uint64_t(1) << 61;
+        corrupted_data.replace(offset, sizeof(huge_count), reinterpret_cast<const char*>(&huge_count), sizeof(huge_count));
+        std::stringstream corrupted(corrupted_data);
+        BOOST_CHECK(!loaded.Load(corrupted));
+        BOOST_CHECK_EQUAL(loaded.GetComponent<TestComponent0>(ent2).a, 12);
+    }
+    // an available entity which was never saved
+    {
+        std::string corrupted_data = data;
+        const EntityIdType unknown_id = EntityIdType(1) << 40;
+        corrupted_data.replace(available_count_offset + 8, sizeof(unknown_id), reinterpret_cast<const char*>(&unknown_id), sizeof(unknown_id));
+        std::stringstream corrupted(corrupted_data);
+        BOOST_CHECK(!loaded.Load(corrupted));
+    }
+    // a component block claiming more components than the stream contains
+    {
+        std::stringstream corrupted;
+        WriteValue(corrupted, Serializer<TestComponent0>::kVersion);
+        WriteValue(corrupted, static_cast<std::uint64_t>(sizeof(TestComponent0)));
+        WriteValue(corrupted, static_cast<std::uint64_t>(1000));
+        BOOST_CHECK(!ComponentMap<TestComponent0>().Read(corrupted));
+    }
+}
+
+BOOST_AUTO_TEST_CASE( clone_entity_manager )
+{
+    using namespace test_entity_manager_namespace;
+
+    EntityManager entity_manager;
+    entity_manager.RegisterComponent<TestComponent0>();
+    Entity ent0 = entity_manager.CreateEntity();
+    entity_manager.AddComponent(ent0, TestComponent0{5});
+
+    // modifying the clone does not modify the original
+    EntityManager clone = entity_manager.Clone();
+    clone.GetComponent<TestComponent0>(ent0).a = 6;
+    Entity ent1 = clone.CreateEntity();
+    clone.AddComponent(ent1, TestComponent0{7});
+
+    BOOST_CHECK_EQUAL(entity_manager.GetComponent<TestComponent0>(ent0).a, 5);
+    BOOST_CHECK_EQUAL(entity_manager.GetExistingEntitiesCount(), 1);
+    BOOST_CHECK_EQUAL(clone.GetComponent<TestComponent0>(ent0).a, 6);
+    BOOST_CHECK_EQUAL(clone.GetExistingEntitiesCount(), 2);
+}
+
+BOOST_AUTO_TEST_CASE( observe_components )
+{
+    using namespace test_entity_manager_namespace;
+
+    EntityManager entity_manager;
+    entity_manager.RegisterComponent<TestComponent0>();
+    entity_manager.RegisterComponent<TestComponent1>();
+
+    std::vector<EntityIdType> added;
+    std::vector<EntityIdType> removed;
+    std::vector<EntityIdType> changed;
+    std::vector<std::vector<Entity>> added_batches;
+    int removed_value = 0;
+    entity_manager.Observe<TestComponent0>(ComponentEvent::kAdd, [&](Entity e) { added.push_back(e.id_); });
+    entity_manager.Observe<TestComponent0>(ComponentEvent::kRemove, [&](Entity e) {
+        removed.push_back(e.id_);
+        // the component still exists while removal observers are called
+        removed_value = entity_manager.PeekComponent<TestComponent0>(e).a;
+    });
+    ObserverIdType change_observer = entity_manager.Observe<TestComponent0>(ComponentEvent::kChange, [&](Entity e) { changed.push_back(e.id_); });
+    entity_manager.ObserveBatch<TestComponent0>(ComponentEvent::kAdd, [&](const std::vector<Entity>& batch) { added_batches.push_back(batch); });
+
+    /* additions */
+
+    Entity ent0 = entity_manager.CreateEntity();
+    Entity ent1 = entity_manager.CreateEntity();
+    entity_manager.AddComponent(ent0, TestComponent0{1});
+    entity_manager.AddComponent(ent1, TestComponent0{2});
+    entity_manager.AddComponent(ent1, TestComponent1{3});     // nobody observes TestComponent1
+    BOOST_CHECK_EQUAL(added.size(), 2);
+    BOOST_CHECK_EQUAL(added_batches.size(), 0);     // batches are delivered when flushing
+
+    /* changes are delivered when flushing, once per component */
+
+    entity_manager.GetComponent<TestComponent0>(ent1).a = 20;
+    entity_manager.GetComponent<TestComponent0>(ent1).a += 1;
+    BOOST_CHECK_EQUAL(changed.size(), 0);
+    entity_manager.FlushObservers();
+    BOOST_CHECK_EQUAL(added_batches.size(), 1);
+    BOOST_CHECK_EQUAL(added_batches[0].size(), 2);
+    BOOST_CHECK_EQUAL(changed.size(), 1);
+    BOOST_CHECK_EQUAL(changed[0], ent1.id_);
+
+    // flushing another component type does not deliver them
+    entity_manager.GetComponent<TestComponent0>(ent1);
+    entity_manager.FlushObservers<TestComponent1>();
+    BOOST_CHECK_EQUAL(changed.size(), 1);
+    entity_manager.FlushObservers<TestComponent0>();
+    BOOST_CHECK_EQUAL(changed.size(), 2);
+
+    // nothing new to flush
+    entity_manager.FlushObservers();
+    BOOST_CHECK_EQUAL(added_batches.size(), 1);
+    BOOST_CHECK_EQUAL(changed.size(), 2);
+
+    /* removals, also via destroying the entity */
+
+    entity_manager.RemoveComponent<TestComponent0>(ent0);
+    BOOST_CHECK_EQUAL(removed.size(), 1);
+    BOOST_CHECK_EQUAL(removed_value, 1);
+    entity_manager.GetComponent<TestComponent0>(ent1);
+    entity_manager.DestroyEntity(ent1);
+    BOOST_CHECK_EQUAL(removed.size(), 2);
+    BOOST_CHECK_EQUAL(removed_value, 21);
+    // the changed component no longer exists
+    entity_manager.FlushObservers();
+    BOOST_CHECK_EQUAL(changed.size(), 2);
+
+    /* unobserve */
+
+    entity_manager.Unobserve<TestComponent0>(change_observer);
+    Entity ent2 = entity_manager.CreateEntity();
+    entity_manager.AddComponent(ent2, TestComponent0{4});
+    entity_manager.GetComponent<TestComponent0>(ent2);
+    entity_manager.FlushObservers();
+    BOOST_CHECK_EQUAL(changed.size(), 2);
+    BOOST_CHECK_EQUAL(added.size(), 3);
+
+    /* forward to the event manager */
+
+    EventManager event_manager;
+    auto process = std::make_shared<TestObserverProcess>();
+    event_manager.Subscribe<ComponentAdded<TestComponent0>>(process);
+    event_manager.Subscribe<ComponentChanged<TestComponent0>>(process);
+    entity_manager.ForwardToEventManager<TestComponent0>(event_manager);
+
+    Entity ent3 = entity_manager.CreateEntity();
+    entity_manager.AddComponent(ent3, TestComponent0{5});
+    entity_manager.GetComponent<TestComponent0>(ent3).a = 6;
+    BOOST_CHECK_EQUAL(process->added.size(), 1);
+    BOOST_CHECK_EQUAL(process->changed.size(), 0);
+    entity_manager.FlushObservers();
+    BOOST_CHECK_EQUAL(process->changed.size(), 1);
+    BOOST_CHECK_EQUAL(process->changed[0], ent3.id_);
+
+    // nobody subscribed to ComponentRemoved, so the removal is not delivered to anyone
+    entity_manager.RemoveComponent<TestComponent0>(ent3);
+    BOOST_CHECK_EQUAL(process->added.size(), 1);
+    BOOST_CHECK_EQUAL(process->changed.size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE( tag_components )
+{
+    using namespace test_entity_manager_namespace;
+
+    EntityManager entity_manager;
+    entity_manager.RegisterComponent<TestComponent0>();
+    entity_manager.RegisterComponent<TestTag>();
+    std::vector<EntityIdType> added;
+    std::vector<EntityIdType> removed;
+    entity_manager.Observe<TestTag>(ComponentEvent::kAdd, [&](Entity e) { added.push_back(e.id_); });
+    entity_manager.Observe<TestTag>(ComponentEvent::kRemove, [&](Entity e) { removed.push_back(e.id_); });
+
+    Entity ent0 = entity_manager.CreateEntity();
+    Entity ent1 = entity_manager.CreateEntity();
+    Entity ent2 = entity_manager.CreateEntity();
+    entity_manager.AddComponent<TestTag>(ent0);
+    entity_manager.AddComponent(ent1, TestTag{});
+    entity_manager.AddComponent(ent1, TestComponent0{1});
+    BOOST_CHECK(entity_manager.HasComponent<TestTag>(ent0));
+    BOOST_CHECK(entity_manager.HasComponent<TestTag>(ent1));
+    BOOST_CHECK(!entity_manager.HasComponent<TestTag>(ent2));
+    BOOST_CHECK_EQUAL(entity_manager.GetBitField(ent1), (entity_manager.ComponentBitFieldOf<TestComponent0, TestTag>()));
+    BOOST_CHECK_EQUAL(added.size(), 2);
+
+    entity_manager.RemoveComponent<TestTag>(ent0);
+    BOOST_CHECK(!entity_manager.HasComponent<TestTag>(ent0));
+    BOOST_CHECK_EQUAL(removed.size(), 1);
+    entity_manager.AddComponent<TestTag>(ent2);
+    entity_manager.DestroyEntity(ent2);
+    BOOST_CHECK_EQUAL(removed.size(), 2);
+
+    /* snapshots and clones keep the tags */
+
+    std::stringstream snapshot;
+    BOOST_CHECK(entity_manager.Save(snapshot));
+    EntityManager loaded;
+    loaded.RegisterComponent<TestComponent0>();
+    loaded.RegisterComponent<TestTag>();
+    BOOST_CHECK(loaded.Load(snapshot));
+    BOOST_CHECK(!loaded.HasComponent<TestTag>(ent0));
+    BOOST_CHECK(loaded.HasComponent<TestTag>(ent1));
+    BOOST_CHECK_EQUAL(loaded.GetComponent<TestComponent0>(ent1).a, 1);
+
+    EntityManager clone = entity_manager.Clone();
+    clone.RemoveComponent<TestTag>(ent1);
+    BOOST_CHECK(entity_manager.HasComponent<TestTag>(ent1));
+
+    /* deltas replicate additions and removals */
+
+    EntityManager client;
+    client.RegisterComponent<TestComponent0>();
+    client.RegisterComponent<TestTag>();
+    TickType delta_tick;
+    BOOST_CHECK(client.ApplyDelta(entity_manager.EncodeDelta(0), delta_tick));
+    BOOST_CHECK(client.HasComponent<TestTag>(ent1));
+    BOOST_CHECK(!client.HasComponent<TestTag>(ent0));
+
+    entity_manager.AdvanceTick();
+    entity_manager.AddComponent<TestTag>(ent0);
+    entity_manager.RemoveComponent<TestTag>(ent1);
+    BOOST_CHECK(client.ApplyDelta(entity_manager.EncodeDelta(delta_tick), delta_tick));
+    BOOST_CHECK(client.HasComponent<TestTag>(ent0));
+    BOOST_CHECK(!client.HasComponent<TestTag>(ent1));
+    BOOST_CHECK(client.HasComponent<TestComponent0>(ent1));
+
+    /* tags of entities with huge IDs do not allocate memory per ID */
+
+    for (EntityIdType huge_id : {EntityIdType(1) << 36, EntityIdType(1) << 62})
+    {
+        // a tag on a single entity: tick, number of component types, replicated flag, one addition, no removals, no destroyed entities
+        BitWriter writer;
+        writer.WriteVarUint(1);
+        writer.WriteVarUint(1);
+        writer.WriteBool(true);
+        writer.WriteVarUint(1);
+        writer.WriteVarUint(huge_id);
+        writer.WriteVarUint(0);
+        writer.WriteVarUint(0);
+        EntityManager tag_client;
+        tag_client.RegisterComponent<TestTag>();
+        BOOST_CHECK(tag_client.ApplyDelta(writer.GetBuffer(), delta_tick));
+        BOOST_CHECK(tag_client.HasComponent<TestTag>(Entity{huge_id}));
+    }
+
+    // the last ID of the snapshot is the ID of the last tagged entity
+    std::string corrupted_data = snapshot.str();
+    const EntityIdType huge_id = EntityIdType(1) << 40;
+    corrupted_data.replace(corrupted_data.size() - sizeof(huge_id), sizeof(huge_id), reinterpret_cast<const char*>(&huge_id), sizeof(huge_id));
+    std::stringstream corrupted(corrupted_data);
+    EntityManager corrupted_loaded;
+    corrupted_loaded.RegisterComponent<TestComponent0>();
+    corrupted_loaded.RegisterComponent<TestTag>();
+    BOOST_CHECK(!corrupted_loaded.Load(corrupted));
+}
+
+BOOST_AUTO_TEST_CASE( singleton_resources )
+{
+    using namespace test_entity_manager_namespace;
+
+    EntityManager entity_manager;
+    BOOST_CHECK(!entity_manager.HasResource<TestSeed>());
+    entity_manager.SetResource(TestSeed{42});
+    entity_manager.SetResource(TestComponent0{7});
+    BOOST_CHECK(entity_manager.HasResource<TestSeed>());
+    BOOST_CHECK_EQUAL(entity_manager.GetResource<TestSeed>().seed, 42);
+    entity_manager.GetResource<TestSeed>().seed = 43;
+    BOOST_CHECK_EQUAL(entity_manager.GetResource<TestSeed>().seed, 43);
+    BOOST_CHECK_EQUAL(entity_manager.GetResource<TestComponent0>().a, 7);
+
+    // the clone has its own copy
+    EntityManager clone = entity_manager.Clone();
+    clone.GetResource<TestSeed>().seed = 44;
+    BOOST_CHECK_EQUAL(entity_manager.GetResource<TestSeed>().seed, 43);
+    BOOST_CHECK_EQUAL(clone.GetResource<TestSeed>().seed, 44);
+
+    // resources are independent of other entity managers
+    EntityManager other;
+    BOOST_CHECK(!other.HasResource<TestSeed>());
+
+    entity_manager.RemoveResource<TestSeed>();
+    BOOST_CHECK(!entity_manager.HasResource<TestSeed>());
+    BOOST_CHECK(clone.HasResource<TestSeed>());
+}
+
+BOOST_AUTO_TEST_CASE( compact_components )
+{
+    using namespace test_entity_manager_namespace;
+
+    EntityManager entity_manager;
+    entity_manager.RegisterComponent<TestComponent0>();
+    auto cm_tc0 = entity_manager.GetComponentMap<TestComponent0>();
+
+    // churn: every other entity is destroyed and its node is reused by a new entity
+    std::vector<Entity> entities;
+    for (int i = 0; i < 1000; ++i)
+    {
+        entities.push_back(entity_manager.CreateEntity());
+        entity_manager.AddComponent(entities.back(), TestComponent0{i});
+    }
+    BOOST_CHECK(cm_tc0->GetDisorder() < 0.01);
+    for (int i = 0; i < 1000; i += 2)
+    {
+        entity_manager.DestroyEntity(entities[i]);
+    }
+    for (int i = 0; i < 300; ++i)
+    {
+        entities.push_back(entity_manager.CreateEntity());
+        entity_manager.AddComponent(entities.back(), TestComponent0{1000 + i});
+    }
+    BOOST_CHECK(cm_tc0->GetDisorder() > 0.1);
+
+    /* without budget nothing happens */
+
+    BOOST_CHECK(!entity_manager.CompactComponents(std::chrono::microseconds(0)));
+    BOOST_CHECK(cm_tc0->GetDisorder() > 0.1);
+
+    /* compaction keeps entities and components */
+
+    BOOST_CHECK(entity_manager.CompactComponents(std::chrono::seconds(10)));
+    // the components lie next to each other in entity ID order (except between the blocks of the pool)
+    BOOST_CHECK_EQUAL(cm_tc0->GetDisorder(), 0);
+    const TestComponent0* previous = nullptr;
+    std::size_t out_of_order = 0;
+    for (auto const& i : cm_tc0->entity_component_map_)
+    {
+        out_of_order += previous && std::less<const void*>()(&i.second, previous) ? 1 : 0;
+        previous = &i.second;
+    }
+    BOOST_CHECK(out_of_order <= 800 / NodePool::NODES_PER_BLOCK);
+    BOOST_CHECK_EQUAL(cm_tc0->entity_component_map_.size(), 800);
+    BOOST_CHECK_EQUAL(entity_manager.GetComponent<TestComponent0>(entities[1]).a, 1);
+    BOOST_CHECK_EQUAL(entity_manager.GetComponent<TestComponent0>(entities[1299]).a, 1299);
+
+    /* maps which are in order are not rebuilt */
+
+    const TestComponent0* component = &entity_manager.PeekComponent<TestComponent0>(entities[1]);
+    BOOST_CHECK(entity_manager.CompactComponents(std::chrono::seconds(10)));
+    BOOST_CHECK_EQUAL(&entity_manager.PeekComponent<TestComponent0>(entities[1]), component);
+
+    // a clone gets its own nodes
+    EntityManager clone = entity_manager.Clone();
+    clone.DestroyEntity(entities[1]);
+    BOOST_CHECK_EQUAL(entity_manager.PeekComponent<TestComponent0>(entities[1]).a, 1);
+
+    /* a map is compacted in steps, the components stay accessible in between */
+
+    for (int i = 1; i < 1000; i += 4)
+    {
+        entity_manager.DestroyEntity(entities[i]);
+    }
+    for (int i = 0; i < 100; ++i)
+    {
+        entities.push_back(entity_manager.CreateEntity());
+        entity_manager.AddComponent(entities.back(), TestComponent0{1300 + i});
+    }
+    BOOST_CHECK_EQUAL(cm_tc0->entity_component_map_.size(), 650);
+    int steps = 1;
+    while (!cm_tc0->Compact(100))
+    {
+        ++steps;
+        BOOST_CHECK_EQUAL(entity_manager.GetComponent<TestComponent0>(entities[3]).a, 3);
+        BOOST_CHECK_EQUAL(entity_manager.GetComponent<TestComponent0>(entities[1399]).a, 1399);
+        entity_manager.AddComponent(entity_manager.CreateEntity(), TestComponent0{-1});
+    }
+    // the components added in between are moved as well (if their IDs come after the last step)
+    BOOST_CHECK(steps >= 7);
+    BOOST_CHECK_EQUAL(entity_manager.GetComponent<TestComponent0>(entities[1299]).a, 1299);
+}
+
+BOOST_AUTO_TEST_CASE( move_pool_allocated_map )
+{
+    using namespace test_entity_manager_namespace;
+
+    // a moved-from map keeps usable pools
+    ComponentMap<TestComponent0>::Map a;
+    a.emplace(Entity{1}, TestComponent0{1});
+    ComponentMap<TestComponent0>::Map b = std::move(a);
+    a.emplace(Entity{2}, TestComponent0{2});
+    BOOST_CHECK_EQUAL(a.size(), 1);
+    BOOST_CHECK_EQUAL(b.size(), 1);
+    BOOST_CHECK_EQUAL(b.at(Entity{1}).a, 1);
+
+    ComponentMap<TestComponent0>::Map c;
+    c = std::move(b);
+    b.emplace(Entity{3}, TestComponent0{3});
+    BOOST_CHECK_EQUAL(b.size(), 1);
+    BOOST_CHECK_EQUAL(c.at(Entity{1}).a, 1);
+}
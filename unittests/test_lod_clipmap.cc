@@ -0,0 +1,220 @@
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+#include "chunk.h"
+#include "entity.h"
+#include "entity_manager.h"
+#include "lod_clipmap.h"
+#include "lod_process.h"
+#include "position.h"
+#include "process_manager.h"
+#include "voxel_world.h"
+
+namespace test_lod_clipmap_namespace {
+    const BlockType STONE = 1;
+    const BlockType GRASS = 2;
+
+    // ground plane: stone below y = 0, grass at y = 0 (loaded for chunks with x and z in [-8, 8))
+    void MakeGround(VoxelWorld& world)
+    {
+        for (int cx = -8; cx < 8; ++cx)
+        {
+            for (int cz = -8; cz < 8; ++cz)
+            {
+                auto chunk = std::make_shared<Chunk>();
+                for (int x = 0; x < CHUNK_SIZE; ++x)
+                {
+                    for (int z = 0; z < CHUNK_SIZE; ++z)
+                    {
+                        for (int y = 0; y < CHUNK_SIZE; ++y)
+                        {
+                            chunk->SetBlock(x, y, z, STONE);
+                        }
+                    }
+                }
+                world.SetChunk(ChunkCoord{cx, -1, cz}, chunk);
+                chunk = std::make_shared<Chunk>();
+                for (int x = 0; x < CHUNK_SIZE; ++x)
+                {
+                    for (int z = 0; z < CHUNK_SIZE; ++z)
+                    {
+                        chunk->SetBlock(x, 0, z, GRASS);
+                    }
+                }
+                world.SetChunk(ChunkCoord{cx, 0, cz}, chunk);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( chunk_coordinates )
+{
+    BOOST_CHECK_EQUAL(FloorDiv(-1, 16), -1);
+    BOOST_CHECK_EQUAL(FloorDiv(-16, 16), -1);
+    BOOST_CHECK_EQUAL(FloorDiv(-17, 16), -2);
+    BOOST_CHECK_EQUAL(FloorDiv(15, 16), 0);
+    BOOST_CHECK_EQUAL(FloorMod(-1, 16), 15);
+
+    VoxelWorld world;
+    world.SetBlock(-1, 5, 17, 3);
+    BOOST_CHECK_EQUAL(world.GetBlock(-1, 5, 17), 3);
+    BOOST_CHECK(world.GetChunk(ChunkCoord{-1, 0, 1}) != nullptr);
+    BOOST_CHECK_EQUAL(world.GetBlock(1000, 0, 0), AIR);
+}
+
+BOOST_AUTO_TEST_CASE( build_and_update_lod_clipmap )
+{
+    using namespace test_lod_clipmap_namespace;
+
+    VoxelWorld world;
+    MakeGround(world);
+    const int levels = 3;
+    const int radius = 2;
+    LodClipmap clipmap(world, levels, radius);
+
+    /* initial build around the origin */
+
+    clipmap.Update(Position{0, 0, 0});
+    const std::uint64_t initial = clipmap.GetBuiltCount();
+    // chunks of regions without loaded world chunks are not built
+    BOOST_CHECK(initial > 0);
+    BOOST_CHECK(initial < clipmap.GetLodChunks().size());
+    BOOST_CHECK(clipmap.IsFullResolution(ChunkCoord{2, -2, -2}));
+    BOOST_CHECK(!clipmap.IsFullResolution(ChunkCoord{3, 0, 0}));
+    // every level has at most (2 * radius + 1)^3 chunks
+    BOOST_CHECK(clipmap.GetLodChunks().size() <= levels * 125);
+
+    // the chunk at level 1 covering the world chunks x in [4, 6) and y in [-2, 0) is outside the full resolution region
+    auto lod_chunk = clipmap.GetLodChunk(1, ChunkCoord{2, -1, 0});
+    BOOST_REQUIRE(lod_chunk != nullptr);
+    // its upper half is stone, the lower half is not loaded
+    BOOST_CHECK_EQUAL(lod_chunk->GetBlock(0, CHUNK_SIZE / 2, 0), STONE);
+    BOOST_CHECK_EQUAL(lod_chunk->GetBlock(0, CHUNK_SIZE / 2 - 1, 0), AIR);
+    // the grass layer is half of a cell and thus kept
+    lod_chunk = clipmap.GetLodChunk(1, ChunkCoord{2, 0, 0});
+    BOOST_REQUIRE(lod_chunk != nullptr);
+    BOOST_CHECK_EQUAL(lod_chunk->GetBlock(0, 0, 0), GRASS);
+    BOOST_CHECK_EQUAL(lod_chunk->GetBlock(0, 1, 0), AIR);
+    // far away chunks without loaded world chunks are empty
+    auto far_chunk = clipmap.GetLodChunk(3, ChunkCoord{2, 0, 2});
+    BOOST_REQUIRE(far_chunk != nullptr);
+    BOOST_CHECK(far_chunk->IsEmpty());
+    // the center is covered by finer levels
+    BOOST_CHECK(clipmap.GetLodChunk(1, ChunkCoord{0, 0, 0}) == nullptr);
+
+    /* no movement, nothing to build */
+
+    clipmap.Update(Position{5, 3, 5});
+    BOOST_CHECK_EQUAL(clipmap.GetBuiltCount(), 0);
+
+    /* moving by one chunk only builds the new boundary (most of which has been built for the coarser levels) */
+
+    clipmap.Update(Position{CHUNK_SIZE, 0, 0});
+    BOOST_CHECK(clipmap.GetBuiltCount() < initial / 2);
+    BOOST_CHECK(clipmap.IsFullResolution(ChunkCoord{3, 0, 0}));
+
+    /* changing a block rebuilds the chunks containing it */
+
+    BOOST_CHECK_EQUAL(clipmap.GetLodChunk(1, ChunkCoord{-2, -1, 0})->GetBlock(0, CHUNK_SIZE / 2, 0), STONE);
+    for (int x = -64; x < -62; ++x)
+    {
+        for (int y = -16; y < -14; ++y)
+        {
+            for (int z = 0; z < 2; ++z)
+            {
+                world.SetBlock(x, y, z, GRASS);
+            }
+        }
+    }
+    clipmap.Update(Position{CHUNK_SIZE, 0, 0});
+    // only the level 1 chunk is rebuilt, the coarser chunks containing the blocks are covered by level 1
+    BOOST_CHECK_EQUAL(clipmap.GetBuiltCount(), 1);
+    BOOST_CHECK_EQUAL(clipmap.GetLodChunk(1, ChunkCoord{-2, -1, 0})->GetBlock(0, CHUNK_SIZE / 2, 0), GRASS);
+}
+
+BOOST_AUTO_TEST_CASE( build_coarse_levels_from_finer_ones )
+{
+    using namespace test_lod_clipmap_namespace;
+
+    VoxelWorld world;
+    MakeGround(world);
+    // the level 6 chunks cover 64 x 64 x 64 world chunks
+    LodClipmap clipmap(world, 6, 1);
+    clipmap.Update(Position{0, 0, 0});
+
+    // the stone (y in [-16, 0)) lies in the level 6 chunk y = -1 (a half solid cell stays solid on every level)
+    auto coarse = clipmap.GetLodChunk(6, ChunkCoord{-1, -1, -1});
+    BOOST_REQUIRE(coarse != nullptr);
+    BOOST_CHECK(!coarse->IsEmpty());
+    BOOST_CHECK(clipmap.GetLodChunk(6, ChunkCoord{1, 1, 1})->IsEmpty());
+
+    /* changing a block only rebuilds the chunks containing it */
+
+    auto unchanged = clipmap.GetLodChunk(5, ChunkCoord{1, -1, -1});
+    BOOST_REQUIRE(unchanged != nullptr);
+    world.SetBlock(-100, -5, -100, GRASS);
+    clipmap.Update(Position{0, 0, 0});
+    BOOST_CHECK(clipmap.GetBuiltCount() <= 6);
+    BOOST_CHECK(clipmap.GetLodChunk(5, ChunkCoord{1, -1, -1}) == unchanged);
+    BOOST_CHECK(clipmap.GetLodChunk(6, ChunkCoord{-1, -1, -1}) != coarse);
+
+    /* unloading the world keeps the downsampled chunks */
+
+    coarse = clipmap.GetLodChunk(6, ChunkCoord{-1, -1, -1});
+    auto fine = clipmap.GetLodChunk(1, ChunkCoord{-1, -1, -1});
+    BOOST_REQUIRE(fine != nullptr);
+    BOOST_CHECK_EQUAL(fine->GetBlock(0, CHUNK_SIZE / 2, 0), STONE);
+    std::vector<ChunkCoord> coords;
+    for (auto const& i : world.GetChunks())
+    {
+        coords.push_back(i.first);
+    }
+    for (auto coord : coords)
+    {
+        world.RemoveChunk(coord);
+    }
+    clipmap.Update(Position{0, 0, 0});
+    BOOST_CHECK_EQUAL(clipmap.GetBuiltCount(), 0);
+    BOOST_CHECK(clipmap.GetLodChunk(6, ChunkCoord{-1, -1, -1}) == coarse);
+    BOOST_CHECK(!clipmap.GetLodChunk(6, ChunkCoord{-1, -1, -1})->IsEmpty());
+
+    // loading a chunk again rebuilds the chunks containing it, the octants of unloaded chunks keep their cells
+    world.SetChunk(ChunkCoord{-2, -1, -2}, std::make_shared<Chunk>());
+    clipmap.Update(Position{0, 0, 0});
+    fine = clipmap.GetLodChunk(1, ChunkCoord{-1, -1, -1});
+    BOOST_CHECK_EQUAL(fine->GetBlock(0, CHUNK_SIZE / 2, 0), AIR);
+    BOOST_CHECK_EQUAL(fine->GetBlock(CHUNK_SIZE - 1, CHUNK_SIZE / 2, 0), STONE);
+    BOOST_CHECK(!clipmap.GetLodChunk(6, ChunkCoord{-1, -1, -1})->IsEmpty());
+
+    /* cached chunks far away from the center are evicted */
+
+    const std::uint64_t cached = clipmap.GetCachedCount();
+    clipmap.Update(Position{0, 0, 1000 * CHUNK_SIZE});
+    BOOST_CHECK(clipmap.GetCachedCount() < cached);
+}
+
+BOOST_AUTO_TEST_CASE( lod_process_follows_player )
+{
+    using namespace test_lod_clipmap_namespace;
+
+    VoxelWorld world;
+    MakeGround(world);
+    EntityManager entity_manager;
+    entity_manager.RegisterComponent<Position>();
+    Entity player = entity_manager.CreateEntity();
+    entity_manager.AddComponent(player, Position{0, 0, 0});
+
+    ProcessManager process_manager;
+    process_manager.RegisterProcess<LodProcess>(0, entity_manager, world, player, 2, 2);
+    auto lod_process = process_manager.GetProcess<LodProcess>();
+
+    process_manager.Update();
+    BOOST_CHECK(lod_process->GetClipmap().GetBuiltCount() > 0);
+    BOOST_CHECK(lod_process->GetClipmap().IsFullResolution(ChunkCoord{0, 0, 0}));
+
+    entity_manager.GetComponent<Position>(player).x = 10 * CHUNK_SIZE;
+    process_manager.Update();
+    BOOST_CHECK(!lod_process->GetClipmap().IsFullResolution(ChunkCoord{0, 0, 0}));
+    BOOST_CHECK(lod_process->GetClipmap().IsFullResolution(ChunkCoord{10, 0, 0}));
+}
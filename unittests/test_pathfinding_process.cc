@@ -0,0 +1,228 @@
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "chunk.h"
+#include "entity.h"
+#include "event_manager.h"
+#include "path_graph.h"
+#include "pathfinding_process.h"
+#include "process.h"
+#include "process_manager.h"
+#include "thread_pool.h"
+#include "voxel_world.h"
+
+namespace test_pathfinding_process_namespace {
+    const BlockType STONE = 1;
+
+    class TestMobProcess : public IProcess
+    {
+    public:
+        void Update()
+        {
+        }
+
+        void Receive(PathFound& e)
+        {
+            results.push_back(e);
+        }
+
+        std::vector<PathFound> results;
+    };
+
+    // 3 x 1 x 3 loaded chunks of air with a stone wall at x = 24 (in chunk x = 1) which has a door at z = 40
+    void MakeWorld(VoxelWorld& world)
+    {
+        for (int cx = 0; cx < 3; ++cx)
+        {
+            for (int cz = 0; cz < 3; ++cz)
+            {
+                world.SetChunk(ChunkCoord{cx, 0, cz}, std::make_shared<Chunk>());
+            }
+        }
+        for (int y = 0; y < CHUNK_SIZE; ++y)
+        {
+            for (int z = 0; z < 3 * CHUNK_SIZE; ++z)
+            {
+                if (z != 40)
+                {
+                    world.SetBlock(24, y, z, STONE);
+                }
+            }
+        }
+    }
+
+    // consecutive blocks are neighbors and all blocks are passable
+    bool IsValidPath(const PathGraph& graph, const std::vector<BlockCoord>& path)
+    {
+        for (std::size_t i = 0; i < path.size(); ++i)
+        {
+            if (!graph.IsPassable(path[i]))
+            {
+                return false;
+            }
+            if (i > 0 && std::abs(path[i].x - path[i - 1].x) + std::abs(path[i].y - path[i - 1].y) + std::abs(path[i].z - path[i - 1].z) != 1)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+BOOST_AUTO_TEST_CASE( run_parallel_for )
+{
+    ThreadPool thread_pool(3);
+    std::vector<int> values(1000, 0);
+    for (int round = 0; round < 10; ++round)
+    {
+        thread_pool.ParallelFor(values.size(), [&values](std::size_t i) { ++values[i]; });
+    }
+    for (auto v : values)
+    {
+        BOOST_CHECK_EQUAL(v, 10);
+    }
+
+    // without worker threads
+    ThreadPool no_threads(0);
+    std::atomic<int> sum{0};
+    no_threads.ParallelFor(5, [&sum](std::size_t i) { sum += static_cast<int>(i); });
+    BOOST_CHECK_EQUAL(sum, 10);
+}
+
+BOOST_AUTO_TEST_CASE( find_paths_through_chunks )
+{
+    using namespace test_pathfinding_process_namespace;
+
+    VoxelWorld world;
+    MakeWorld(world);
+    EventManager event_manager;
+    ProcessManager process_manager;
+    process_manager.RegisterProcess<PathfindingProcess>(0, world, event_manager, 2);
+    process_manager.RegisterProcess<TestMobProcess>(1);
+    auto pathfinding = process_manager.GetProcess<PathfindingProcess>();
+    auto mobs = process_manager.GetProcess<TestMobProcess>();
+    event_manager.Subscribe<PathFound>(mobs);
+
+    /* a path through the door */
+
+    const BlockCoord start{2, 0, 2};
+    const BlockCoord goal{40, 0, 2};
+    const std::uint64_t id = pathfinding->RequestPath(Entity{7}, start, goal);
+    BOOST_CHECK_EQUAL(mobs->results.size(), 0);
+    process_manager.Update();
+    BOOST_REQUIRE_EQUAL(mobs->results.size(), 1);
+    const PathFound& result = mobs->results[0];
+    BOOST_CHECK_EQUAL(result.request_id, id);
+    BOOST_CHECK_EQUAL(result.requester.id_, 7);
+    BOOST_REQUIRE(result.found);
+    BOOST_CHECK(result.path.front() == start);
+    BOOST_CHECK(result.path.back() == goal);
+    BOOST_CHECK(IsValidPath(pathfinding->GetGraph(), result.path));
+    // the detour through the door at z = 40 is at least 2 * 38 blocks longer than the straight line
+    BOOST_CHECK(result.path.size() > 38 + 2 * 38);
+    // and not much longer than the shortest one (38 + 2 * 38 steps)
+    BOOST_CHECK(result.path.size() < 1.2 * (38 + 2 * 38) + 1);
+
+    /* a path within one chunk */
+
+    pathfinding->RequestPath(Entity{8}, BlockCoord{1, 1, 1}, BlockCoord{5, 9, 14});
+    process_manager.Update();
+    BOOST_REQUIRE_EQUAL(mobs->results.size(), 2);
+    BOOST_CHECK(mobs->results[1].found);
+    BOOST_CHECK_EQUAL(mobs->results[1].path.size(), 4 + 8 + 13 + 1);
+
+    /* mobs in the same chunk with the same goal share the route */
+
+    mobs->results.clear();
+    for (int i = 0; i < 10; ++i)
+    {
+        pathfinding->RequestPath(Entity{static_cast<EntityIdType>(i)}, BlockCoord{i, 3, 5}, goal);
+    }
+    process_manager.Update();
+    BOOST_REQUIRE_EQUAL(mobs->results.size(), 10);
+    for (auto const& r : mobs->results)
+    {
+        BOOST_CHECK(r.found);
+        BOOST_CHECK(IsValidPath(pathfinding->GetGraph(), r.path));
+        BOOST_CHECK(r.path.back() == goal);
+    }
+    BOOST_CHECK_EQUAL(pathfinding->GetCacheHitCount(), 10);     // the route searched for the first request (same start chunk and goal) is still cached
+
+    /* closing the door: the graph is rebuilt and there is no path anymore */
+
+    for (int y = 0; y < CHUNK_SIZE; ++y)
+    {
+        world.SetBlock(24, y, 40, STONE);
+    }
+    mobs->results.clear();
+    pathfinding->RequestPath(Entity{9}, start, goal);
+    process_manager.Update();
+    BOOST_REQUIRE_EQUAL(mobs->results.size(), 1);
+    BOOST_CHECK(!mobs->results[0].found);
+    BOOST_CHECK(mobs->results[0].path.empty());
+
+    // blocks in chunks which are not loaded are not passable
+    mobs->results.clear();
+    pathfinding->RequestPath(Entity{10}, start, BlockCoord{100, 0, 0});
+    process_manager.Update();
+    BOOST_CHECK(!mobs->results[0].found);
+}
+
+BOOST_AUTO_TEST_CASE( invalidate_and_bound_cached_routes )
+{
+    using namespace test_pathfinding_process_namespace;
+
+    VoxelWorld world;
+    MakeWorld(world);
+    EventManager event_manager;
+    ProcessManager process_manager;
+    process_manager.RegisterProcess<PathfindingProcess>(0, world, event_manager, 2, 2);
+    process_manager.RegisterProcess<TestMobProcess>(1);
+    auto pathfinding = process_manager.GetProcess<PathfindingProcess>();
+    auto mobs = process_manager.GetProcess<TestMobProcess>();
+    event_manager.Subscribe<PathFound>(mobs);
+
+    /* changes in chunks the route does not pass through keep it cached */
+
+    const BlockCoord start{1, 1, 1};
+    const BlockCoord goal{5, 9, 14};
+    pathfinding->RequestPath(Entity{1}, start, goal);
+    process_manager.Update();
+    BOOST_CHECK_EQUAL(pathfinding->GetCachedRouteCount(), 1);
+    world.SetBlock(40, 3, 40, STONE);   // chunk (2, 0, 2), its neighbors are rebuilt as well
+    pathfinding->RequestPath(Entity{2}, start, goal);
+    process_manager.Update();
+    BOOST_CHECK_EQUAL(pathfinding->GetCacheHitCount(), 1);
+    BOOST_CHECK_EQUAL(pathfinding->GetCachedRouteCount(), 1);
+
+    /* changes in chunks the route passes through drop it */
+
+    world.SetBlock(10, 3, 10, STONE);
+    pathfinding->RequestPath(Entity{3}, start, goal);
+    process_manager.Update();
+    BOOST_CHECK_EQUAL(pathfinding->GetCacheHitCount(), 1);
+    BOOST_REQUIRE_EQUAL(mobs->results.size(), 3);
+    BOOST_CHECK(mobs->results[2].found);
+
+    /* the least recently used routes are dropped when the cache is full */
+
+    pathfinding->RequestPath(Entity{4}, start, BlockCoord{6, 9, 14});
+    process_manager.Update();
+    pathfinding->RequestPath(Entity{5}, start, goal);
+    process_manager.Update();
+    BOOST_CHECK_EQUAL(pathfinding->GetCacheHitCount(), 2);
+    pathfinding->RequestPath(Entity{6}, start, BlockCoord{7, 9, 14});
+    process_manager.Update();
+    BOOST_CHECK_EQUAL(pathfinding->GetCachedRouteCount(), 2);
+    pathfinding->RequestPath(Entity{7}, start, goal);
+    process_manager.Update();
+    BOOST_CHECK_EQUAL(pathfinding->GetCacheHitCount(), 3);
+    pathfinding->RequestPath(Entity{8}, start, BlockCoord{6, 9, 14});
+    process_manager.Update();
+    BOOST_CHECK_EQUAL(pathfinding->GetCacheHitCount(), 3);
+    BOOST_CHECK_EQUAL(pathfinding->GetCachedRouteCount(), 2);
+}
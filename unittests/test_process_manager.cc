@@ -1,5 +1,9 @@
 #include <boost/test/unit_test.hpp>
 
+#include <chrono>
+#include <thread>
+
+#include "event_manager.h"
 #include "process.h"
 #include "process_manager.h"
 
@@ -23,6 +27,42 @@ namespace test_process_manager_namespace{
         }
         int a1 = -1;
     };
+
+    // counts its updates and stores the tick of the last one
+    template <int N>
+    class CountingProcess : public IProcess
+    {
+    public:
+        explicit CountingProcess(const ProcessManager& process_manager) : process_manager_(process_manager)
+        {
+        }
+
+        void Update()
+        {
+            ++updates;
+            last_tick = process_manager_.GetTick();
+        }
+
+        int updates = 0;
+        std::uint64_t last_tick = 0;
+
+    private:
+        const ProcessManager& process_manager_;
+    };
+
+    // takes longer than the frame budget
+    class SlowProcess : public IProcess
+    {
+    public:
+        void Update()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    };
+
+    struct WakeUp
+    {
+    };
 }
 
 BOOST_AUTO_TEST_CASE( register_get_and_update_processes )
@@ -64,3 +104,90 @@ BOOST_AUTO_TEST_CASE( register_get_and_update_processes )
     BOOST_CHECK_EQUAL(tp2->a0, 4);
     BOOST_CHECK_EQUAL(tp3->a1, -4);
 }
+
+BOOST_AUTO_TEST_CASE( schedule_processes )
+{
+    using namespace test_process_manager_namespace;
+
+    ProcessManager process_manager;
+    process_manager.RegisterProcess<CountingProcess<0>>(0, process_manager);
+    process_manager.RegisterProcess<CountingProcess<1>>(1, process_manager);
+    process_manager.RegisterProcess<CountingProcess<2>>(2, process_manager);
+    process_manager.RegisterProcess<CountingProcess<3>>(3, process_manager);
+    auto every_frame = process_manager.GetProcess<CountingProcess<0>>();
+    auto every_4th_a = process_manager.GetProcess<CountingProcess<1>>();
+    auto every_4th_b = process_manager.GetProcess<CountingProcess<2>>();
+    auto four_hz = process_manager.GetProcess<CountingProcess<3>>();
+    process_manager.SetSchedule<CountingProcess<1>>(ProcessSchedule::EveryNthTick(4));
+    process_manager.SetSchedule<CountingProcess<2>>(ProcessSchedule::EveryNthTick(4));
+    process_manager.SetSchedule<CountingProcess<3>>(ProcessSchedule::Hz(4));
+
+    /* rates and staggering */
+
+    // 16 frames of 1/8 second
+    for (int i = 0; i < 16; ++i)
+    {
+        process_manager.Update(std::chrono::duration<double>(0.125));
+    }
+    BOOST_CHECK_EQUAL(process_manager.GetTick(), 16);
+    BOOST_CHECK_EQUAL(every_frame->updates, 16);
+    BOOST_CHECK_EQUAL(every_4th_a->updates, 4);
+    BOOST_CHECK_EQUAL(every_4th_b->updates, 4);
+    // the processes with the same rate are not updated on the same tick
+    BOOST_CHECK(every_4th_a->last_tick != every_4th_b->last_tick);
+    // at 0.125 s (the first update is due immediately), then every 0.25 s
+    BOOST_CHECK_EQUAL(four_hz->updates, 9);
+
+    /* sleeping and waking */
+
+    process_manager.Sleep<CountingProcess<0>>();
+    BOOST_CHECK(process_manager.IsAsleep<CountingProcess<0>>());
+    process_manager.Update(std::chrono::duration<double>(0.125));
+    BOOST_CHECK_EQUAL(every_frame->updates, 16);
+
+    EventManager event_manager;
+    process_manager.WakeOn<WakeUp, CountingProcess<0>>(event_manager);
+    process_manager.Update(std::chrono::duration<double>(0.125));
+    BOOST_CHECK_EQUAL(every_frame->updates, 16);
+    event_manager.Publish(WakeUp{});
+    BOOST_CHECK(!process_manager.IsAsleep<CountingProcess<0>>());
+    process_manager.Update(std::chrono::duration<double>(0.125));
+    BOOST_CHECK_EQUAL(every_frame->updates, 17);
+
+    // a woken process is updated in the next frame even if it is not due
+    const int updates = every_4th_a->updates;
+    process_manager.Sleep<CountingProcess<1>>();
+    process_manager.Wake<CountingProcess<1>>();
+    process_manager.Update(std::chrono::duration<double>(0.125));
+    BOOST_CHECK_EQUAL(every_4th_a->updates, updates + 1);
+}
+
+BOOST_AUTO_TEST_CASE( shed_optional_processes )
+{
+    using namespace test_process_manager_namespace;
+
+    ProcessManager process_manager;
+    process_manager.RegisterProcess<SlowProcess>(0);
+    process_manager.RegisterProcess<CountingProcess<0>>(1, process_manager);
+    process_manager.RegisterProcess<CountingProcess<1>>(2, process_manager);
+    auto optional = process_manager.GetProcess<CountingProcess<0>>();
+    auto required = process_manager.GetProcess<CountingProcess<1>>();
+    ProcessSchedule schedule;
+    schedule.optional = true;
+    process_manager.SetSchedule<CountingProcess<0>>(schedule);
+
+    // without a budget, nothing is deferred
+    process_manager.Update();
+    BOOST_CHECK_EQUAL(optional->updates, 1);
+    BOOST_CHECK_EQUAL(process_manager.GetDeferredCount(), 0);
+
+    // the slow process exceeds the budget: the optional process is deferred every other frame
+    process_manager.SetFrameBudget(std::chrono::microseconds(1000));
+    for (int i = 0; i < 4; ++i)
+    {
+        process_manager.Update();
+    }
+    BOOST_CHECK_EQUAL(required->updates, 5);
+    BOOST_CHECK_EQUAL(optional->updates, 3);
+    BOOST_CHECK_EQUAL(process_manager.GetDeferredCount(), 2);
+}
@@ -0,0 +1,200 @@
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <sstream>
+#include <vector>
+
+#include "bit_stream.h"
+#include "entity.h"
+#include "entity_manager.h"
+#include "loopback_transport.h"
+#include "network_codec.h"
+
+namespace test_replication_namespace {
+    struct TestPosition
+    {
+        float x = 0;
+    };
+    struct TestHealth
+    {
+        int h = 100;
+    };
+}
+
+// positions are quantized to 16 bits in [-1000, 1000]
+template <>
+struct NetworkCodec<test_replication_namespace::TestPosition>
+{
+    static constexpr bool kCustom = true;
+
+    static void Encode(BitWriter& writer, const test_replication_namespace::TestPosition& position)
+    {
+        writer.WriteBits(QuantizeFloat(position.x, -1000, 1000, 16), 16);
+    }
+
+    static bool Decode(BitReader& reader, test_replication_namespace::TestPosition& position)
+    {
+        position.x = DequantizeFloat(reader.ReadBits(16), -1000, 1000, 16);
+        return reader.Ok();
+    }
+};
+
+BOOST_AUTO_TEST_CASE( write_and_read_bits )
+{
+    BitWriter writer;
+    writer.WriteBits(5, 3);
+    writer.WriteBool(true);
+    writer.WriteVarUint(3);
+    writer.WriteVarUint(300);
+    writer.WriteBits(0xabcdef, 24);
+    // 3 + 1 + 8 + 16 + 24 bits
+    BOOST_CHECK_EQUAL(writer.GetBitCount(), 52);
+    BOOST_CHECK_EQUAL(writer.GetBuffer().size(), 7);
+
+    BitReader reader(writer.GetBuffer());
+    BOOST_CHECK_EQUAL(reader.ReadBits(3), 5);
+    BOOST_CHECK_EQUAL(reader.ReadBool(), true);
+    BOOST_CHECK_EQUAL(reader.ReadVarUint(), 3);
+    BOOST_CHECK_EQUAL(reader.ReadVarUint(), 300);
+    BOOST_CHECK_EQUAL(reader.ReadBits(24), 0xabcdef);
+    BOOST_CHECK(reader.Ok());
+
+    // reading past the end
+    reader.ReadBits(16);
+    BOOST_CHECK(!reader.Ok());
+
+    /* quantization */
+
+    BOOST_CHECK_EQUAL(QuantizeFloat(-1000, -1000, 1000, 16), 0);
+    BOOST_CHECK_EQUAL(QuantizeFloat(5000, -1000, 1000, 16), 65535);
+    BOOST_CHECK(std::abs(DequantizeFloat(QuantizeFloat(12.34f, -1000, 1000, 16), -1000, 1000, 16) - 12.34f) < 0.02f);
+}
+
+BOOST_AUTO_TEST_CASE( track_changes_and_replicate_deltas )
+{
+    using namespace test_replication_namespace;
+
+    EntityManager server;
+    server.RegisterComponent<TestPosition>();
+    server.RegisterComponent<TestHealth>();
+    EntityManager client;
+    client.RegisterComponent<TestPosition>();
+    client.RegisterComponent<TestHealth>();
+    LoopbackTransport transport;
+
+    std::vector<Entity> entities;
+    for (int i = 0; i < 10; ++i)
+    {
+        Entity entity = server.CreateEntity();
+        server.AddComponent(entity, TestPosition{float(i)});
+        server.AddComponent(entity, TestHealth{});
+        entities.push_back(entity);
+    }
+
+    /* the first delta contains the full state */
+
+    TickType acked_tick = 0;
+    transport.Send(server.EncodeDelta(acked_tick));
+    std::vector<std::uint8_t> packet;
+    BOOST_CHECK(transport.Receive(packet));
+    BOOST_CHECK(client.ApplyDelta(packet, acked_tick));
+    // the delta is stamped with the tick it was encoded at, then the tick is advanced
+    BOOST_CHECK_EQUAL(acked_tick + 1, server.GetTick());
+    BOOST_CHECK_EQUAL(client.GetExistingEntitiesCount(), 10);
+    BOOST_CHECK_EQUAL(client.GetBitField(entities[3]), server.GetBitField(entities[3]));
+    BOOST_CHECK(std::abs(client.PeekComponent<TestPosition>(entities[3]).x - 3) < 0.02f);
+    BOOST_CHECK_EQUAL(client.PeekComponent<TestHealth>(entities[3]).h, 100);
+    const std::uint64_t full_size = packet.size();
+
+    /* nothing changed */
+
+    server.AdvanceTick();
+    BOOST_CHECK_EQUAL(server.PeekComponent<TestHealth>(entities[0]).h, 100);    // peeking is not a change
+    std::vector<std::uint8_t> empty_delta = server.EncodeDelta(acked_tick);
+    BOOST_CHECK(empty_delta.size() < 9);     // the counts of changed and removed components per type and of destroyed entities
+
+    /* change one component, remove another one */
+
+    server.GetComponent<TestHealth>(entities[5]).h = 42;
+    server.RemoveComponent<TestPosition>(entities[7]);
+    transport.Send(server.EncodeDelta(acked_tick));
+    BOOST_CHECK(transport.Receive(packet));
+    BOOST_CHECK(packet.size() < full_size / 4);
+    BOOST_CHECK(client.ApplyDelta(packet, acked_tick));
+    BOOST_CHECK_EQUAL(client.PeekComponent<TestHealth>(entities[5]).h, 42);
+    BOOST_CHECK_EQUAL(client.GetBitField(entities[7]), server.GetBitField(entities[7]));
+    BOOST_CHECK_EQUAL(client.GetComponentMap<TestPosition>()->entity_component_map_.size(), 9);
+
+    // destroying an entity removes all its components
+    server.AdvanceTick();
+    server.DestroyEntity(entities[2]);
+    transport.Send(server.EncodeDelta(acked_tick));
+    BOOST_CHECK(transport.Receive(packet));
+    BOOST_CHECK(client.ApplyDelta(packet, acked_tick));
+    BOOST_CHECK_EQUAL(client.GetBitField(entities[2]), ComponentBitField());
+    // the destruction itself is replicated as well
+    BOOST_CHECK_EQUAL(client.GetExistingEntitiesCount(), 9);
+    BOOST_CHECK_EQUAL(client.GetExistingEntitiesCount(), server.GetExistingEntitiesCount());
+
+    // once acknowledged, removals are no longer needed
+    server.DiscardRemovalsUpTo(acked_tick);
+    BOOST_CHECK_EQUAL(server.GetComponentMap<TestHealth>()->removal_tick_.size(), 0);
+
+    /* invalid deltas are rejected without modifying the receiver */
+
+    server.AdvanceTick();
+    server.GetComponent<TestHealth>(entities[1]).h = 1;
+    packet = server.EncodeDelta(acked_tick);
+    packet.resize(packet.size() - 1);
+    BOOST_CHECK(!client.ApplyDelta(packet, acked_tick));
+    BOOST_CHECK_EQUAL(client.PeekComponent<TestHealth>(entities[1]).h, 100);
+}
+
+BOOST_AUTO_TEST_CASE( replicate_changes_and_destructions_after_encoding )
+{
+    using namespace test_replication_namespace;
+
+    EntityManager server;
+    server.RegisterComponent<TestHealth>();
+    EntityManager client;
+    client.RegisterComponent<TestHealth>();
+
+    Entity entity = server.CreateEntity();
+    server.AddComponent(entity, TestHealth{});
+    TickType acked_tick = 0;
+    BOOST_CHECK(client.ApplyDelta(server.EncodeDelta(acked_tick), acked_tick));
+
+    /* a change right after encoding (without advancing the tick) is part of the next delta */
+
+    server.GetComponent<TestHealth>(entity).h = 2;
+    server.AdvanceTick();
+    BOOST_CHECK(client.ApplyDelta(server.EncodeDelta(acked_tick), acked_tick));
+    BOOST_CHECK_EQUAL(client.PeekComponent<TestHealth>(entity).h, 2);
+
+    /* destroyed entities are destroyed on the client and can be reused */
+
+    server.DestroyEntity(entity);
+    BOOST_CHECK(client.ApplyDelta(server.EncodeDelta(acked_tick), acked_tick));
+    BOOST_CHECK_EQUAL(client.GetExistingEntitiesCount(), 0);
+    BOOST_CHECK_EQUAL(client.GetBitField(entity), ComponentBitField());
+
+    // the server reuses the ID, the client must not hand it out anymore
+    Entity reused = server.CreateEntity();
+    BOOST_CHECK_EQUAL(reused.id_, entity.id_);
+    server.AddComponent(reused, TestHealth{7});
+    BOOST_CHECK(client.ApplyDelta(server.EncodeDelta(acked_tick), acked_tick));
+    BOOST_CHECK_EQUAL(client.GetExistingEntitiesCount(), 1);
+    BOOST_CHECK_EQUAL(client.PeekComponent<TestHealth>(reused).h, 7);
+    Entity local = client.CreateEntity();
+    BOOST_CHECK(local.id_ != reused.id_);
+    BOOST_CHECK_EQUAL(client.GetExistingEntitiesCount(), 2);
+
+    // snapshots only contain the entities which are still available
+    std::stringstream snapshot;
+    BOOST_CHECK(client.Save(snapshot));
+    EntityManager loaded;
+    loaded.RegisterComponent<TestHealth>();
+    BOOST_CHECK(loaded.Load(snapshot));
+    Entity created = loaded.CreateEntity();
+    BOOST_CHECK(created.id_ != reused.id_ && created.id_ != local.id_);
+}
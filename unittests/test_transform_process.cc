@@ -0,0 +1,134 @@
+#include <boost/test/unit_test.hpp>
+
+#include <sstream>
+
+#include "entity.h"
+#include "entity_manager.h"
+#include "process_manager.h"
+#include "transform.h"
+#include "transform_process.h"
+
+BOOST_AUTO_TEST_CASE( propagate_transforms_through_hierarchy )
+{
+    EntityManager entity_manager;
+    entity_manager.RegisterComponent<Transform>();
+    entity_manager.RegisterComponent<WorldTransform>();
+    entity_manager.RegisterComponent<Hierarchy>();
+
+    ProcessManager process_manager;
+    process_manager.RegisterProcess<TransformProcess>(0, entity_manager);
+    auto transform_process = process_manager.GetProcess<TransformProcess>();
+
+    /* a mob holding an item with an attached particle, and an unrelated static entity */
+
+    Entity mob = entity_manager.CreateEntity();
+    Entity item = entity_manager.CreateEntity();
+    Entity particle = entity_manager.CreateEntity();
+    Entity block = entity_manager.CreateEntity();
+    entity_manager.AddComponent(mob, Transform{10, 0, 0, 2});
+    entity_manager.AddComponent(item, Transform{1, 1, 0, 1});
+    entity_manager.AddComponent(item, Hierarchy{mob});
+    entity_manager.AddComponent(particle, Transform{0, 0.5f, 0, 1});
+    entity_manager.AddComponent(particle, Hierarchy{item});
+    entity_manager.AddComponent(block, Transform{-5, 0, 3, 1});
+
+    process_manager.Update();
+    BOOST_CHECK_EQUAL(transform_process->GetUpdatedCount(), 4);
+    const WorldTransform& item_world = entity_manager.PeekComponent<WorldTransform>(item);
+    BOOST_CHECK_EQUAL(item_world.x, 12);
+    BOOST_CHECK_EQUAL(item_world.y, 2);
+    BOOST_CHECK_EQUAL(item_world.scale, 2);
+    const WorldTransform& particle_world = entity_manager.PeekComponent<WorldTransform>(particle);
+    BOOST_CHECK_EQUAL(particle_world.x, 12);
+    BOOST_CHECK_EQUAL(particle_world.y, 3);
+    BOOST_CHECK_EQUAL(entity_manager.PeekComponent<WorldTransform>(block).z, 3);
+
+    /* nothing changed, nothing is recomputed */
+
+    process_manager.Update();
+    BOOST_CHECK_EQUAL(transform_process->GetUpdatedCount(), 0);
+
+    /* moving the mob moves its subtree only */
+
+    entity_manager.GetComponent<Transform>(mob).x = 20;
+    process_manager.Update();
+    BOOST_CHECK_EQUAL(transform_process->GetUpdatedCount(), 3);
+    BOOST_CHECK_EQUAL(entity_manager.PeekComponent<WorldTransform>(particle).x, 22);
+    BOOST_CHECK_EQUAL(entity_manager.PeekComponent<WorldTransform>(block).x, -5);
+
+    // moving a leaf only recomputes the leaf
+    entity_manager.GetComponent<Transform>(particle).x = 1;
+    process_manager.Update();
+    BOOST_CHECK_EQUAL(transform_process->GetUpdatedCount(), 1);
+    BOOST_CHECK_EQUAL(entity_manager.PeekComponent<WorldTransform>(particle).x, 24);
+
+    /* reparenting: the mob drops the item, which is then attached to the block */
+
+    entity_manager.GetComponent<Hierarchy>(item).parent = block;
+    process_manager.Update();
+    BOOST_CHECK_EQUAL(entity_manager.PeekComponent<WorldTransform>(item).x, -4);
+    BOOST_CHECK_EQUAL(entity_manager.PeekComponent<WorldTransform>(particle).x, -3);
+
+    // detaching makes the item a root
+    entity_manager.RemoveComponent<Hierarchy>(item);
+    process_manager.Update();
+    BOOST_CHECK_EQUAL(entity_manager.PeekComponent<WorldTransform>(item).x, 1);
+    BOOST_CHECK_EQUAL(entity_manager.PeekComponent<WorldTransform>(particle).x, 2);
+
+    /* only the notifications of Transform and Hierarchy are flushed by the process */
+
+    int world_transform_changes = 0;
+    entity_manager.Observe<WorldTransform>(ComponentEvent::kChange, [&](Entity) { ++world_transform_changes; });
+    entity_manager.GetComponent<WorldTransform>(block);
+    entity_manager.GetComponent<Transform>(block).x = -6;
+    process_manager.Update();
+    BOOST_CHECK_EQUAL(transform_process->GetUpdatedCount(), 1);
+    BOOST_CHECK_EQUAL(world_transform_changes, 0);
+    entity_manager.FlushObservers();
+    BOOST_CHECK_EQUAL(world_transform_changes, 1);
+
+    /* world transforms are written only if they changed */
+
+    world_transform_changes = 0;
+    entity_manager.GetComponent<Transform>(item);
+    process_manager.Update();
+    entity_manager.FlushObservers();
+    BOOST_CHECK_EQUAL(transform_process->GetUpdatedCount(), 2);
+    BOOST_CHECK_EQUAL(world_transform_changes, 0);
+    entity_manager.GetComponent<Transform>(item).x = 3;
+    process_manager.Update();
+    entity_manager.FlushObservers();
+    BOOST_CHECK_EQUAL(world_transform_changes, 2);
+    BOOST_CHECK_EQUAL(entity_manager.PeekComponent<WorldTransform>(particle).x, 4);
+}
+
+BOOST_AUTO_TEST_CASE( rebuild_after_loading_snapshot )
+{
+    EntityManager entity_manager;
+    entity_manager.RegisterComponent<Transform>();
+    entity_manager.RegisterComponent<WorldTransform>();
+    entity_manager.RegisterComponent<Hierarchy>();
+
+    ProcessManager process_manager;
+    process_manager.RegisterProcess<TransformProcess>(0, entity_manager);
+
+    // a snapshot with the parent only
+    Entity parent = entity_manager.CreateEntity();
+    entity_manager.AddComponent(parent, Transform{1, 0, 0, 1});
+    std::stringstream snapshot;
+    BOOST_CHECK(entity_manager.Save(snapshot));
+
+    Entity child = entity_manager.CreateEntity();
+    entity_manager.AddComponent(child, Transform{1, 0, 0, 1});
+    entity_manager.AddComponent(child, Hierarchy{parent});
+    process_manager.Update();
+    BOOST_CHECK_EQUAL(entity_manager.PeekComponent<WorldTransform>(child).x, 2);
+
+    /* the process sees the removed child and the replaced components of the parent */
+
+    BOOST_CHECK(entity_manager.Load(snapshot));
+    entity_manager.GetComponent<Transform>(parent).x = 5;
+    process_manager.Update();
+    BOOST_CHECK_EQUAL(entity_manager.PeekComponent<WorldTransform>(parent).x, 5);
+    BOOST_CHECK(!entity_manager.HasComponent<Transform>(child));
+}
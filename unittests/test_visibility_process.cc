@@ -0,0 +1,143 @@
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "chunk.h"
+#include "chunk_connectivity.h"
+#include "frustum.h"
+#include "process_manager.h"
+#include "visibility_process.h"
+#include "voxel_world.h"
+
+namespace test_visibility_process_namespace {
+    const BlockType STONE = 1;
+
+    bool Contains(const std::vector<ChunkCoord>& chunks, ChunkCoord coord)
+    {
+        return std::find(chunks.begin(), chunks.end(), coord) != chunks.end();
+    }
+
+    // solid ground chunks at y = -1 above a layer of (loaded) cave chunks at y = -2
+    void MakeGroundAndCaves(VoxelWorld& world)
+    {
+        for (int cx = -3; cx <= 3; ++cx)
+        {
+            for (int cz = -3; cz <= 3; ++cz)
+            {
+                auto ground = std::make_shared<Chunk>();
+                for (int x = 0; x < CHUNK_SIZE; ++x)
+                {
+                    for (int y = 0; y < CHUNK_SIZE; ++y)
+                    {
+                        for (int z = 0; z < CHUNK_SIZE; ++z)
+                        {
+                            ground->SetBlock(x, y, z, STONE);
+                        }
+                    }
+                }
+                world.SetChunk(ChunkCoord{cx, -1, cz}, ground);
+                auto cave = std::make_shared<Chunk>();
+                cave->SetBlock(0, 0, 0, STONE);
+                world.SetChunk(ChunkCoord{cx, -2, cz}, cave);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( cull_boxes_with_frustum )
+{
+    // looking along +x with a field of view of 90 degrees
+    Frustum frustum = Frustum::FromPerspective(Vec3{0, 0, 0}, Vec3{1, 0, 0}, Vec3{0, 1, 0}, 1.5708f, 1, 0.1f, 100);
+    BOOST_CHECK(frustum.IsPointInside(Vec3{10, 0, 0}));
+    BOOST_CHECK(frustum.IsPointInside(Vec3{10, 9, -9}));
+    BOOST_CHECK(!frustum.IsPointInside(Vec3{-10, 0, 0}));
+    BOOST_CHECK(!frustum.IsPointInside(Vec3{10, 11, 0}));
+    BOOST_CHECK(!frustum.IsPointInside(Vec3{200, 0, 0}));
+
+    AabbArrays boxes;
+    boxes.Resize(4);
+    const float mins[4][3] = {{5, -1, -1}, {-20, -1, -1}, {10, 15, 0}, {10, 8, -1}};
+    for (int i = 0; i < 4; ++i)
+    {
+        boxes.min_x[i] = mins[i][0];
+        boxes.min_y[i] = mins[i][1];
+        boxes.min_z[i] = mins[i][2];
+        boxes.max_x[i] = mins[i][0] + 4;
+        boxes.max_y[i] = mins[i][1] + 4;
+        boxes.max_z[i] = mins[i][2] + 4;
+    }
+    std::vector<char> visible;
+    frustum.CullAabbs(boxes, visible);
+    BOOST_CHECK_EQUAL(visible[0], 1);   // in front
+    BOOST_CHECK_EQUAL(visible[1], 0);   // behind
+    BOOST_CHECK_EQUAL(visible[2], 0);   // above
+    BOOST_CHECK_EQUAL(visible[3], 1);   // intersects the upper plane
+}
+
+BOOST_AUTO_TEST_CASE( compute_chunk_connectivity )
+{
+    Chunk chunk;
+    BOOST_CHECK(ChunkConnectivity::Compute(chunk).IsConnected(kNegX, kPosY));
+
+    // a solid wall at y = 8 separates the lower and upper faces
+    for (int x = 0; x < CHUNK_SIZE; ++x)
+    {
+        for (int z = 0; z < CHUNK_SIZE; ++z)
+        {
+            chunk.SetBlock(x, 8, z, 1);
+        }
+    }
+    ChunkConnectivity connectivity = ChunkConnectivity::Compute(chunk);
+    BOOST_CHECK(!connectivity.IsConnected(kNegY, kPosY));
+    BOOST_CHECK(connectivity.IsConnected(kNegX, kPosX));
+    BOOST_CHECK(connectivity.IsConnected(kNegY, kPosZ));
+    BOOST_CHECK(connectivity.IsConnected(kPosY, kNegZ));
+
+    // a hole connects them again
+    chunk.SetBlock(3, 8, 3, AIR);
+    BOOST_CHECK(ChunkConnectivity::Compute(chunk).IsConnected(kNegY, kPosY));
+}
+
+BOOST_AUTO_TEST_CASE( cull_occluded_chunks )
+{
+    using namespace test_visibility_process_namespace;
+
+    VoxelWorld world;
+    MakeGroundAndCaves(world);
+
+    ProcessManager process_manager;
+    process_manager.RegisterProcess<VisibilityProcess>(0, world, 4);
+    auto visibility = process_manager.GetProcess<VisibilityProcess>();
+
+    /* looking down from above the ground: the caves are behind the solid ground */
+
+    const Vec3 eye{8, 8, 8};
+    visibility->SetCamera(eye, Frustum::FromPerspective(eye, Vec3{0, -1, 0}, Vec3{0, 0, 1}, 1.5708f, 1, 0.1f, 200));
+    process_manager.Update();
+    auto visible = visibility->GetVisibleChunks();
+    BOOST_CHECK(Contains(visible, ChunkCoord{0, -1, 0}));
+    BOOST_CHECK(Contains(visible, ChunkCoord{1, -1, 1}));
+    BOOST_CHECK(!Contains(visible, ChunkCoord{0, -2, 0}));
+    BOOST_CHECK(visibility->GetInFrustumCount() > visible.size());
+
+    /* digging a shaft through the ground chunk makes the caves visible */
+
+    for (int y = -CHUNK_SIZE; y < 0; ++y)
+    {
+        world.SetBlock(8, y, 8, AIR);
+    }
+    process_manager.Update();
+    visible = visibility->GetVisibleChunks();
+    BOOST_CHECK(Contains(visible, ChunkCoord{0, -2, 0}));
+    BOOST_CHECK(Contains(visible, ChunkCoord{1, -2, 0}));
+
+    /* looking along +x: the chunks behind the camera are culled by the frustum */
+
+    visibility->SetCamera(eye, Frustum::FromPerspective(eye, Vec3{1, 0, 0}, Vec3{0, 1, 0}, 1.5708f, 1, 0.1f, 200));
+    process_manager.Update();
+    visible = visibility->GetVisibleChunks();
+    BOOST_CHECK(Contains(visible, ChunkCoord{2, -1, 0}));
+    BOOST_CHECK(!Contains(visible, ChunkCoord{-2, -1, 0}));
+}